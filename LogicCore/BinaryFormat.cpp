@@ -0,0 +1,515 @@
+#include "BinaryFormat.h"
+#include "IntegratedChip.h"
+#include "Serialization.h"
+#include "Simulation.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <tuple>
+#include <unordered_map>
+
+// Pins of a primitive gate, or of a chip built from definition
+static int inputPinCount(GateType type, const BinaryCircuit* definition) {
+    switch (type) {
+        case GateType::OR:
+        case GateType::AND:
+        case GateType::XOR:
+            return 2;
+        case GateType::NOT:
+        case GateType::LIGHT:
+            return 1;
+        case GateType::INTEGRATED:
+            return definition->inputCount;
+        default:
+            return 0;
+    }
+}
+
+static int outputPinCount(GateType type, const BinaryCircuit* definition) {
+    switch (type) {
+        case GateType::LIGHT:
+            return 0;
+        case GateType::INTEGRATED:
+            return definition->outputCount;
+        default:
+            return 1;
+    }
+}
+
+static uint64_t align(uint64_t offset) {
+    return (offset + 7) & ~7ull;
+}
+
+bool BinaryCircuitFile::open(const std::string& fileName) {
+    close();
+
+    if (!file.open(fileName)) {
+        std::cerr << "cannot map " << fileName << std::endl;
+        return false;
+    }
+
+    if (!check(fileName)) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void BinaryCircuitFile::close() {
+    circuits.clear();
+    file.close();
+}
+
+bool BinaryCircuitFile::check(const std::string& fileName) {
+    const char* data = file.getData();
+    uint64_t size = file.getSize();
+
+    auto fail = [&](const std::string& reason) {
+        std::cerr << fileName << " : " << reason << std::endl;
+        return false;
+    };
+
+    auto inFile = [&](uint64_t offset, uint64_t bytes) {
+        return offset % 8 == 0 && offset <= size && bytes <= size - offset;
+    };
+
+    if (size < sizeof(BinaryHeader) || std::memcmp(data, BINARY_FORMAT_MAGIC, 4) != 0) {
+        return fail("not a binary save file");
+    }
+
+    const BinaryHeader* header = (const BinaryHeader*)data;
+    if (header->version != BINARY_FORMAT_VERSION) {
+        return fail("binary format version " + std::to_string(header->version) + ", this build reads version " + std::to_string(BINARY_FORMAT_VERSION));
+    }
+    if (header->circuitCount == 0 || !inFile(sizeof(BinaryHeader), (uint64_t)header->circuitCount * sizeof(BinaryCircuitEntry))) {
+        return fail("truncated circuit table");
+    }
+
+    const BinaryCircuitEntry* entries = (const BinaryCircuitEntry*)(data + sizeof(BinaryHeader));
+    std::vector<const BinaryCircuit*> chipDefinitions; // of the circuit being checked, by gate
+
+    for (int c = 0; c < (int)header->circuitCount; c++) {
+        const BinaryCircuitEntry& entry = entries[c];
+        std::string name = "circuit " + std::to_string(c);
+
+        if (entry.gateCount > INT32_MAX / 2 || entry.connectionCount > INT32_MAX / 4 || entry.chipCount > entry.gateCount) {
+            return fail(name + " is too large");
+        }
+        if (!inFile(entry.typesOffset, entry.gateCount) || !inFile(entry.chipsOffset, 4ull * entry.chipCount)
+            || !inFile(entry.positionsOffset, 8ull * entry.gateCount) || !inFile(entry.connectionsOffset, 16ull * entry.connectionCount)) {
+            return fail(name + " is truncated");
+        }
+
+        BinaryCircuit circuit;
+        circuit.gateCount = (int)entry.gateCount;
+        circuit.chipCount = (int)entry.chipCount;
+        circuit.connectionCount = (int)entry.connectionCount;
+        circuit.inputCount = 0;
+        circuit.outputCount = 0;
+        circuit.types = (const uint8_t*)(data + entry.typesOffset);
+        circuit.chips = (const uint32_t*)(data + entry.chipsOffset);
+        circuit.positions = (const float*)(data + entry.positionsOffset);
+        circuit.connections = (const int32_t*)(data + entry.connectionsOffset);
+
+        chipDefinitions.assign(circuit.gateCount, nullptr);
+        int chip = 0;
+
+        for (int g = 0; g < circuit.gateCount; g++) {
+            if (circuit.types[g] > (uint8_t)GateType::INTEGRATED) {
+                return fail(name + " gate " + std::to_string(g) + " has an unknown type");
+            }
+
+            GateType type = circuit.type(g);
+            if (type == GateType::SWITCH) {
+                circuit.inputCount++;
+            }
+            else if (type == GateType::LIGHT) {
+                circuit.outputCount++;
+            }
+            else if (type == GateType::INTEGRATED) {
+                if (chip == circuit.chipCount || circuit.chips[chip] >= (uint32_t)c) {
+                    return fail(name + " gate " + std::to_string(g) + " is a chip with no circuit defined before it");
+                }
+                chipDefinitions[g] = &circuits[circuit.chips[chip++]];
+            }
+        }
+        if (chip != circuit.chipCount) {
+            return fail(name + " has more chip definitions than chips");
+        }
+
+        for (int i = 0; i < circuit.connectionCount; i++) {
+            const int32_t* connection = circuit.connections + i * 4;
+            int gate = connection[0];
+            int source = connection[2];
+
+            if (gate < 0 || gate >= circuit.gateCount || source < 0 || source >= circuit.gateCount
+                || connection[1] < 0 || connection[1] >= inputPinCount(circuit.type(gate), chipDefinitions[gate])
+                || connection[3] < 0 || connection[3] >= outputPinCount(circuit.type(source), chipDefinitions[source])) {
+                return fail(name + " connection " + std::to_string(i) + " refers to a pin that does not exist");
+            }
+        }
+
+        circuits.push_back(circuit);
+    }
+
+    return true;
+}
+
+bool isBinaryFile(const std::string& fileName) {
+    char magic[4] = {};
+
+    std::ifstream ifs(fileName, std::ifstream::in | std::ifstream::binary);
+    ifs.read(magic, 4);
+
+    return ifs && std::memcmp(magic, BINARY_FORMAT_MAGIC, 4) == 0;
+}
+
+void writeBinary(std::ostream& outputStream, const std::vector<BinaryCircuitData>& circuits) {
+    static const char padding[8] = {};
+
+    BinaryHeader header;
+    std::memcpy(header.magic, BINARY_FORMAT_MAGIC, 4);
+    header.version = BINARY_FORMAT_VERSION;
+    header.circuitCount = (uint32_t)circuits.size();
+    header.reserved = 0;
+
+    std::vector<BinaryCircuitEntry> entries(circuits.size());
+    uint64_t offset = align(sizeof(BinaryHeader) + circuits.size() * sizeof(BinaryCircuitEntry));
+
+    for (size_t c = 0; c < circuits.size(); c++) {
+        const BinaryCircuitData& circuit = circuits[c];
+        BinaryCircuitEntry& entry = entries[c];
+
+        entry.gateCount = (uint32_t)circuit.types.size();
+        entry.chipCount = (uint32_t)circuit.chips.size();
+        entry.connectionCount = (uint32_t)(circuit.connections.size() / 4);
+        entry.reserved = 0;
+
+        entry.typesOffset = offset;
+        offset = align(offset + entry.gateCount);
+        entry.chipsOffset = offset;
+        offset = align(offset + 4ull * entry.chipCount);
+        entry.positionsOffset = offset;
+        offset = align(offset + 8ull * entry.gateCount);
+        entry.connectionsOffset = offset;
+        offset = align(offset + 16ull * entry.connectionCount);
+    }
+
+    uint64_t written = 0;
+    auto put = [&](const void* bytes, uint64_t count) {
+        outputStream.write(padding, align(written) - written);
+        outputStream.write((const char*)bytes, count);
+        written = align(written) + count;
+    };
+
+    put(&header, sizeof(BinaryHeader));
+    put(entries.data(), entries.size() * sizeof(BinaryCircuitEntry));
+
+    for (const BinaryCircuitData& circuit : circuits) {
+        put(circuit.types.data(), circuit.types.size());
+        put(circuit.chips.data(), circuit.chips.size() * 4);
+        put(circuit.positions.data(), circuit.positions.size() * 4);
+        put(circuit.connections.data(), circuit.connections.size() * 4);
+    }
+    outputStream.write(padding, align(written) - written);
+}
+
+void saveToBinary(std::vector<Gate*>& gates, std::ostream& outputStream) {
+    std::vector<CircuitPtr> list = topoSort(&gates);
+
+    std::unordered_map<CircuitPtr, uint32_t> circuitIndex;
+    std::vector<BinaryCircuitData> circuits(list.size());
+
+    for (size_t c = 0; c < list.size(); c++) {
+        const std::vector<Gate*>& circuit = *list[c];
+        BinaryCircuitData& data = circuits[c];
+        circuitIndex[list[c]] = (uint32_t)c;
+
+        std::unordered_map<Gate*, int32_t> gateNumbers;
+        gateNumbers.reserve(circuit.size());
+
+        for (Gate* gate : circuit) {
+            gateNumbers[gate] = (int32_t)data.types.size();
+            data.types.push_back((uint8_t)gate->getGateType());
+            data.positions.push_back(gate->getPosition().x);
+            data.positions.push_back(gate->getPosition().y);
+
+            if (gate->getGateType() == GateType::INTEGRATED) {
+                data.chips.push_back(circuitIndex[static_cast<IntegratedChip*>(gate)->definition->getCircuit()]);
+            }
+        }
+
+        for (Gate* gate : circuit) {
+            int count = gate->getInputPinCount();
+            Pin* pins = gate->getInputPins();
+            for (int i = 0; i < count; i++) {
+                Pin* outputPin = pins[i].connectedTo;
+                int outputIndex = 0;
+                if (outputPin != nullptr && outputPin->parentGate->getPinIndex(outputPin, PinType::Output, outputIndex)) {
+                    data.connections.push_back(gateNumbers[gate]);
+                    data.connections.push_back(i);
+                    data.connections.push_back(gateNumbers[outputPin->parentGate]);
+                    data.connections.push_back(outputIndex);
+                }
+            }
+        }
+    }
+
+    writeBinary(outputStream, circuits);
+}
+
+static void loadBinaryCircuit(std::vector<Gate*>& gates, const BinaryCircuit& circuit, const std::vector<ChipDefinition*>& definitions, GatePool* pool) {
+    size_t first = gates.size();
+    gates.reserve(first + circuit.gateCount);
+
+    int chip = 0;
+    for (int g = 0; g < circuit.gateCount; g++) {
+        Gate* newGate;
+
+        if (circuit.type(g) == GateType::INTEGRATED) {
+            newGate = newChip(definitions[circuit.chips[chip++]], pool);
+        }
+        else {
+            newGate = newGateOfType(circuit.type(g), pool);
+        }
+
+        newGate->position(Vec2f(circuit.positions[g * 2], circuit.positions[g * 2 + 1]));
+        gates.push_back(newGate);
+    }
+
+    for (int i = 0; i < circuit.connectionCount; i++) {
+        const int32_t* connection = circuit.connections + i * 4;
+
+        Pin* inputPin = gates[first + connection[0]]->getPinByIndex(PinType::Input, connection[1]);
+        Pin* outputPin = gates[first + connection[2]]->getPinByIndex(PinType::Output, connection[3]);
+
+        Pin::connectPins(outputPin, inputPin);
+    }
+}
+
+void loadFromBinary(std::vector<Gate*>& gates, const BinaryCircuitFile& file, GatePool* pool, std::vector<ChipDefinition*>* made) {
+    std::vector<ChipDefinition*> definitions;
+
+    for (int c = 0; c + 1 < file.circuitCount(); c++) {
+        std::vector<Gate*>* newCircuit = new std::vector<Gate*>();
+        GatePool* circuitPool = new GatePool(GATE_POOL_SMALL_BLOCK_SIZE);
+        Simulation::suspend();
+        loadBinaryCircuit(*newCircuit, file.getCircuit(c), definitions, circuitPool);
+        Simulation::resume();
+        definitions.push_back(new ChipDefinition(newCircuit, "CHIP", circuitPool));
+        if (made != nullptr) {
+            made->push_back(definitions.back());
+        }
+    }
+
+    loadBinaryCircuit(gates, file.getTopLevel(), definitions, pool);
+}
+
+namespace {
+
+// What the compiler needs to know about a circuit, whatever the number of its instances
+struct CircuitTables {
+    std::vector<int> inputStart; // first input pin of each gate in drivers
+    std::vector<int> drivers;    // 2 per input pin : source gate, output pin. -1 when unconnected
+    std::vector<int> ordinals;   // of each switch among the switches, its pin on a chip
+    std::vector<int> lights;     // in circuit order, the output pins of a chip
+};
+
+// One instance of a circuit, see Scope in Netlist.cpp
+struct BinaryScope {
+    int parent;
+    int chipGate; // in the parent circuit, -1 at the top level
+    int circuit;
+    std::vector<int> gateNets; // -1 for chips and chip boundaries
+    std::vector<int> children; // scope of each chip gate
+};
+
+class BinaryNetlistCompiler {
+private:
+    Netlist& netlist;
+    const BinaryCircuitFile& file;
+    std::vector<CircuitTables> tables;
+    std::vector<BinaryScope> scopes;
+
+    void buildTables(int c) {
+        const BinaryCircuit& circuit = file.getCircuit(c);
+        CircuitTables& t = tables[c];
+
+        t.inputStart.resize(circuit.gateCount + 1);
+        t.ordinals.assign(circuit.gateCount, -1);
+
+        int pins = 0;
+        int switches = 0;
+        int chip = 0;
+        for (int g = 0; g < circuit.gateCount; g++) {
+            GateType type = circuit.type(g);
+            const BinaryCircuit* definition = type == GateType::INTEGRATED ? &file.getCircuit(circuit.chips[chip++]) : nullptr;
+
+            t.inputStart[g] = pins;
+            pins += inputPinCount(type, definition);
+
+            if (type == GateType::SWITCH) {
+                t.ordinals[g] = switches++;
+            }
+            else if (type == GateType::LIGHT) {
+                t.lights.push_back(g);
+            }
+        }
+        t.inputStart[circuit.gateCount] = pins;
+
+        t.drivers.assign(pins * 2, -1);
+        for (int i = 0; i < circuit.connectionCount; i++) {
+            const int32_t* connection = circuit.connections + i * 4;
+            int pin = t.inputStart[connection[0]] + connection[1];
+            t.drivers[pin * 2] = connection[2];
+            t.drivers[pin * 2 + 1] = connection[3];
+        }
+    }
+
+    int instantiate(int c, int parent, int chipGate) {
+        const BinaryCircuit& circuit = file.getCircuit(c);
+
+        int scope = (int)scopes.size();
+        scopes.push_back(BinaryScope());
+
+        std::vector<int> gateNets(circuit.gateCount, -1);
+        std::vector<int> children;
+        if (circuit.chipCount > 0) {
+            children.assign(circuit.gateCount, -1);
+        }
+
+        int chip = 0;
+        for (int g = 0; g < circuit.gateCount; g++) {
+            GateType type = circuit.type(g);
+
+            if (type == GateType::INTEGRATED) {
+                children[g] = instantiate(circuit.chips[chip++], scope, g);
+                continue;
+            }
+
+            // a chip's switches and lights are only its boundary
+            if (chipGate != -1 && (type == GateType::SWITCH || type == GateType::LIGHT)) {
+                continue;
+            }
+
+            int index = netlist.gateCount();
+            gateNets[g] = index;
+            netlist.types.push_back(type);
+            netlist.origins.push_back(nullptr);
+            for (int i = 0; i < NETLIST_MAX_INPUTS; i++) {
+                netlist.inputNets.push_back(-1);
+            }
+
+            if (chipGate == -1 && type == GateType::SWITCH) {
+                netlist.primaryInputs.push_back(index);
+            }
+            if (chipGate == -1 && type == GateType::LIGHT) {
+                netlist.primaryOutputs.push_back(index);
+            }
+        }
+
+        BinaryScope& s = scopes[scope];
+        s.parent = parent;
+        s.chipGate = chipGate;
+        s.circuit = c;
+        s.gateNets.swap(gateNets);
+        s.children.swap(children);
+
+        return scope;
+    }
+
+    struct WalkState {
+        int gate, pin, scope;
+
+        bool operator<(const WalkState& other) const {
+            return std::tie(gate, pin, scope) < std::tie(other.gate, other.pin, other.scope);
+        }
+    };
+
+    // One hop of walkNet from output pin `pin` of gate, see resolveNet
+    bool crossBoundary(WalkState& state) {
+        if (state.gate == -1) { return false; }
+
+        const BinaryScope& s = scopes[state.scope];
+        GateType type = file.getCircuit(s.circuit).type(state.gate);
+
+        if (type == GateType::INTEGRATED) {
+            // chip output : continue from the light that feeds it, inside the chip
+            int scope = s.children[state.gate];
+            const CircuitTables& inner = tables[scopes[scope].circuit];
+            int driver = inner.inputStart[inner.lights[state.pin]];
+            state = WalkState{ inner.drivers[driver * 2], inner.drivers[driver * 2 + 1], scope };
+            return true;
+        }
+
+        if (type == GateType::SWITCH && s.chipGate != -1) {
+            // chip input : continue from whatever drives the chip pin, outside the chip
+            const CircuitTables& outer = tables[scopes[s.parent].circuit];
+            int driver = outer.inputStart[s.chipGate] + tables[s.circuit].ordinals[state.gate];
+            state = WalkState{ outer.drivers[driver * 2], outer.drivers[driver * 2 + 1], s.parent };
+            return true;
+        }
+
+        return false;
+    }
+
+    // Net driven by output pin `pin` of gate, following it through chip boundaries. -1 when nothing drives it.
+    int resolveNet(int gate, int pin, int scope) {
+        WalkState state{ gate, pin, scope };
+        if (!walkNet(state, [this](WalkState& s) { return crossBoundary(s); }) || state.gate == -1) { return -1; }
+
+        return scopes[state.scope].gateNets[state.gate];
+    }
+
+    void connect(int scope) {
+        const CircuitTables& t = tables[scopes[scope].circuit];
+        int gateCount = (int)scopes[scope].gateNets.size();
+
+        for (int g = 0; g < gateCount; g++) {
+            int index = scopes[scope].gateNets[g];
+            if (index == -1) { continue; }
+
+            int c = t.inputStart[g + 1] - t.inputStart[g];
+            for (int i = 0; i < c && i < NETLIST_MAX_INPUTS; i++) {
+                int driver = t.inputStart[g] + i;
+                netlist.inputNets[index * NETLIST_MAX_INPUTS + i] = resolveNet(t.drivers[driver * 2], t.drivers[driver * 2 + 1], scope);
+            }
+        }
+    }
+
+public:
+    BinaryNetlistCompiler(Netlist& _netlist, const BinaryCircuitFile& _file) : netlist(_netlist), file(_file) {}
+
+    void compile() {
+        tables.resize(file.circuitCount());
+        for (int c = 0; c < file.circuitCount(); c++) {
+            buildTables(c);
+        }
+
+        const BinaryCircuit& top = file.getTopLevel();
+        netlist.types.reserve(top.gateCount);
+        netlist.origins.reserve(top.gateCount);
+        netlist.inputNets.reserve(top.gateCount * NETLIST_MAX_INPUTS);
+
+        instantiate(file.circuitCount() - 1, -1, -1);
+
+        for (int scope = 0; scope < (int)scopes.size(); scope++) {
+            connect(scope);
+        }
+
+        buildFanout(netlist);
+    }
+};
+
+}
+
+Netlist compileNetlist(const BinaryCircuitFile& file) {
+    Netlist netlist;
+
+    BinaryNetlistCompiler compiler(netlist, file);
+    compiler.compile();
+
+    return netlist;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "Gate.h"
+#include "GatePool.h"
+#include "MappedFile.h"
+#include "Netlist.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#define BINARY_FORMAT_MAGIC "LGSB"
+#define BINARY_FORMAT_VERSION 1
+
+// Binary save file, the same content as a saveToFileRecursively file stored as arrays that are used
+// straight from a memory mapping. Little endian, every array starts on an 8 byte boundary :
+//
+//   BinaryHeader
+//   BinaryCircuitEntry x circuitCount  chip definitions first, each only uses the ones before it; top level last
+//   then for every circuit, at the offsets of its entry :
+//     uint8_t  types[gateCount]                  GateType
+//     uint32_t chips[chipCount]                  circuit of each INTEGRATED gate, in gate order
+//     float    positions[2 * gateCount]          x y
+//     int32_t  connections[4 * connectionCount]  gate, input pin, source gate, output pin (save file order)
+
+struct BinaryHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t circuitCount;
+    uint32_t reserved;
+};
+
+struct BinaryCircuitEntry {
+    uint32_t gateCount;
+    uint32_t chipCount;
+    uint32_t connectionCount;
+    uint32_t reserved;
+    uint64_t typesOffset; // from the start of the file
+    uint64_t chipsOffset;
+    uint64_t positionsOffset;
+    uint64_t connectionsOffset;
+};
+
+// One circuit of an open file, pointing into the mapping
+struct BinaryCircuit {
+    int gateCount;
+    int chipCount;
+    int connectionCount;
+    int inputCount;  // switches, the input pins of a chip built from this circuit
+    int outputCount; // lights
+
+    const uint8_t* types;
+    const uint32_t* chips;
+    const float* positions;
+    const int32_t* connections;
+
+    GateType type(int gate) const {
+        return (GateType)types[gate];
+    }
+};
+
+// A mapped and checked binary save file. Opening only reads the header and walks the arrays once to
+// check every index, the data stays in the mapping.
+class BinaryCircuitFile {
+private:
+    MappedFile file;
+    std::vector<BinaryCircuit> circuits;
+
+    bool check(const std::string& fileName);
+
+public:
+    // Prints why to std::cerr when the file is not a valid binary save
+    bool open(const std::string& fileName);
+    void close();
+
+    int circuitCount() const {
+        return (int)circuits.size();
+    }
+
+    const BinaryCircuit& getCircuit(int index) const {
+        return circuits[index];
+    }
+
+    const BinaryCircuit& getTopLevel() const {
+        return circuits.back();
+    }
+};
+
+// Whether the file starts with BINARY_FORMAT_MAGIC, to tell binary saves from text ones
+bool isBinaryFile(const std::string& fileName);
+
+// A circuit to write, in the order of the file arrays
+struct BinaryCircuitData {
+    std::vector<uint8_t> types;
+    std::vector<uint32_t> chips;
+    std::vector<float> positions;
+    std::vector<int32_t> connections;
+};
+
+void writeBinary(std::ostream& outputStream, const std::vector<BinaryCircuitData>& circuits);
+
+// Same circuits as saveToFileRecursively, the output stream must be binary
+void saveToBinary(std::vector<Gate*>& gates, std::ostream& outputStream);
+
+// Builds gate objects like loadFromFileRecursively, appending the top level circuit to gates and the
+// definitions of the chip circuits to made
+void loadFromBinary(std::vector<Gate*>& gates, const BinaryCircuitFile& file, GatePool* pool = nullptr, std::vector<ChipDefinition*>* made = nullptr);
+
+// Flattens the file to a netlist straight from the mapping, without creating gate objects.
+// Gives the same netlist as loading the file and compiling the gates, origins are all nullptr.
+Netlist compileNetlist(const BinaryCircuitFile& file);
@@ -0,0 +1,188 @@
+#include "ChipCache.h"
+#include "Hash.h"
+#include "MappedFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+static uint64_t align(uint64_t offset) {
+    return (offset + 7) & ~7ull;
+}
+
+uint64_t chipCacheKey(uint64_t sourceHash, bool recursive) {
+    uint32_t version = CHIP_CACHE_VERSION;
+    uint64_t hash = hashBytes(FNV_OFFSET, &sourceHash, sizeof(sourceHash));
+    hash = hashBytes(hash, &version, sizeof(version));
+    return hashBytes(hash, recursive ? "r" : "p", 1);
+}
+
+std::string chipCachePath(const std::string& directory, uint64_t key) {
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", (unsigned long long)key);
+    return directory + "/" + name + CHIP_CACHE_EXTENSION;
+}
+
+bool readChipCache(const std::string& directory, uint64_t key, const std::string& source, Netlist& netlist, std::vector<uint64_t>& initialState) {
+    MappedFile file;
+    if (!file.open(chipCachePath(directory, key)) || file.getSize() < sizeof(ChipCacheHeader)) {
+        return false;
+    }
+
+    const char* data = file.getData();
+    const ChipCacheHeader* header = (const ChipCacheHeader*)data;
+
+    if (std::memcmp(header->magic, CHIP_CACHE_MAGIC, 4) != 0 || header->version != CHIP_CACHE_VERSION
+        || header->key != key || header->maxInputs != NETLIST_MAX_INPUTS) {
+        return false;
+    }
+
+    // another file whose hash collides with the key
+    if (header->sourceSize != source.size() || header->sourceCheck != checkBytes(source.data(), source.size())) {
+        return false;
+    }
+
+    uint64_t n = header->gateCount;
+    if (n > INT32_MAX / NETLIST_MAX_INPUTS || header->inputCount > n || header->outputCount > n || header->stateWords != (n + 63) / 64) {
+        return false;
+    }
+
+    // the arrays, in file order
+    uint64_t sizes[] = { n, 4 * NETLIST_MAX_INPUTS * n, 4 * (n + 1), 4ull * header->fanoutCount, 4ull * header->inputCount, 4ull * header->outputCount, 8ull * header->stateWords };
+    const char* arrays[7];
+    uint64_t offset = align(sizeof(ChipCacheHeader));
+    for (int i = 0; i < 7; i++) {
+        if (sizes[i] > file.getSize() || offset > file.getSize() - sizes[i]) {
+            return false;
+        }
+        arrays[i] = data + offset;
+        offset = align(offset + sizes[i]);
+    }
+
+    const uint8_t* types = (const uint8_t*)arrays[0];
+    const int32_t* inputNets = (const int32_t*)arrays[1];
+    const int32_t* fanoutStart = (const int32_t*)arrays[2];
+    const int32_t* fanout = (const int32_t*)arrays[3];
+    const int32_t* primaryInputs = (const int32_t*)arrays[4];
+    const int32_t* primaryOutputs = (const int32_t*)arrays[5];
+
+    // a damaged entry must not send the simulation out of its arrays
+    int gates = (int)n;
+    for (int g = 0; g < gates; g++) {
+        if (types[g] > (uint8_t)GateType::LIGHT || fanoutStart[g] > fanoutStart[g + 1]) {
+            return false;
+        }
+    }
+    if (fanoutStart[0] != 0 || fanoutStart[gates] != (int32_t)header->fanoutCount) {
+        return false;
+    }
+    for (uint64_t i = 0; i < NETLIST_MAX_INPUTS * n; i++) {
+        if (inputNets[i] < -1 || inputNets[i] >= gates) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header->fanoutCount; i++) {
+        if (fanout[i] < 0 || fanout[i] >= gates) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header->inputCount + header->outputCount; i++) {
+        int32_t net = i < header->inputCount ? primaryInputs[i] : primaryOutputs[i - header->inputCount];
+        if (net < 0 || net >= gates) {
+            return false;
+        }
+    }
+
+    netlist.types.resize(gates);
+    for (int g = 0; g < gates; g++) {
+        netlist.types[g] = (GateType)types[g];
+    }
+    netlist.inputNets.assign(inputNets, inputNets + NETLIST_MAX_INPUTS * n);
+    netlist.fanoutStart.assign(fanoutStart, fanoutStart + n + 1);
+    netlist.fanout.assign(fanout, fanout + header->fanoutCount);
+    netlist.primaryInputs.assign(primaryInputs, primaryInputs + header->inputCount);
+    netlist.primaryOutputs.assign(primaryOutputs, primaryOutputs + header->outputCount);
+    netlist.origins.assign(gates, nullptr);
+
+    const uint64_t* state = (const uint64_t*)arrays[6];
+    initialState.assign(state, state + header->stateWords);
+
+    return true;
+}
+
+static void makeDirectory(const std::string& directory) {
+#ifdef _WIN32
+    _mkdir(directory.c_str());
+#else
+    mkdir(directory.c_str(), 0755);
+#endif
+}
+
+bool writeChipCache(const std::string& directory, uint64_t key, const std::string& source, const Netlist& netlist, const std::vector<uint64_t>& initialState) {
+    static const char padding[8] = {};
+
+    makeDirectory(directory); // fails harmlessly when it exists
+
+    std::string path = chipCachePath(directory, key);
+    std::string temporary = path + ".tmp";
+
+    std::ofstream ofs(temporary, std::ofstream::out | std::ofstream::binary);
+    if (!ofs) {
+        return false;
+    }
+
+    ChipCacheHeader header;
+    std::memcpy(header.magic, CHIP_CACHE_MAGIC, 4);
+    header.version = CHIP_CACHE_VERSION;
+    header.key = key;
+    header.sourceSize = source.size();
+    header.sourceCheck = checkBytes(source.data(), source.size());
+    header.gateCount = (uint32_t)netlist.gateCount();
+    header.fanoutCount = (uint32_t)netlist.fanout.size();
+    header.inputCount = (uint32_t)netlist.primaryInputs.size();
+    header.outputCount = (uint32_t)netlist.primaryOutputs.size();
+    header.stateWords = (uint32_t)initialState.size();
+    header.maxInputs = NETLIST_MAX_INPUTS;
+
+    std::vector<uint8_t> types(netlist.types.size());
+    for (size_t g = 0; g < types.size(); g++) {
+        types[g] = (uint8_t)netlist.types[g];
+    }
+
+    uint64_t written = 0;
+    auto put = [&](const void* bytes, uint64_t count) {
+        ofs.write(padding, align(written) - written);
+        ofs.write((const char*)bytes, count);
+        written = align(written) + count;
+    };
+
+    put(&header, sizeof(header));
+    put(types.data(), types.size());
+    put(netlist.inputNets.data(), netlist.inputNets.size() * 4);
+    put(netlist.fanoutStart.data(), netlist.fanoutStart.size() * 4);
+    put(netlist.fanout.data(), netlist.fanout.size() * 4);
+    put(netlist.primaryInputs.data(), netlist.primaryInputs.size() * 4);
+    put(netlist.primaryOutputs.data(), netlist.primaryOutputs.size() * 4);
+    put(initialState.data(), initialState.size() * 8);
+
+    ofs.close();
+    if (!ofs) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+
+    // rename does not replace an existing file everywhere, and an existing entry was found unusable
+    std::remove(path.c_str());
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Netlist.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define CHIP_CACHE_MAGIC "LGSC"
+#define CHIP_CACHE_VERSION 3 // of the entry layout and of the netlist compiler, bump it when either changes
+#define CHIP_CACHE_EXTENSION ".lgsc"
+
+// On-disk cache of compiled chips : the flattened netlist of a chip and its settled power-on state,
+// one file per entry named after its key, so a chip whose save file did not change is never parsed
+// or compiled again. Entries are memory mapped and copied straight into the Netlist vectors.
+//
+// An entry file is, little endian, every array starting on an 8 byte boundary :
+//   ChipCacheHeader
+//   uint8_t  types[gateCount]
+//   int32_t  inputNets[NETLIST_MAX_INPUTS * gateCount]
+//   int32_t  fanoutStart[gateCount + 1]
+//   int32_t  fanout[fanoutCount]
+//   int32_t  primaryInputs[inputCount]
+//   int32_t  primaryOutputs[outputCount]
+//   uint64_t initialState[stateWords]
+
+struct ChipCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint64_t sourceSize;  // bytes of the save file the entry was compiled from
+    uint64_t sourceCheck; // checkBytes of them, the key alone is a 64 bit hash
+    uint32_t gateCount;
+    uint32_t fanoutCount;
+    uint32_t inputCount;
+    uint32_t outputCount;
+    uint32_t stateWords;
+    uint32_t maxInputs; // NETLIST_MAX_INPUTS of the build that wrote it
+};
+
+// Key of the entry for a save file : the content hash of the file, with the way it is loaded and
+// CHIP_CACHE_VERSION folded in
+uint64_t chipCacheKey(uint64_t sourceHash, bool recursive);
+
+// directory/<key in hex>.lgsc
+std::string chipCachePath(const std::string& directory, uint64_t key);
+
+// False when the entry is missing, was written for another key, version or source (the save file's
+// bytes, checked by size and a second hash), or is damaged
+bool readChipCache(const std::string& directory, uint64_t key, const std::string& source, Netlist& netlist, std::vector<uint64_t>& initialState);
+
+// Creates the directory if needed. The entry is written to a temporary file and renamed into place,
+// so a reader never sees half of it.
+bool writeChipCache(const std::string& directory, uint64_t key, const std::string& source, const Netlist& netlist, const std::vector<uint64_t>& initialState);
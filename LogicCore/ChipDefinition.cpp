@@ -0,0 +1,201 @@
+#include "ChipDefinition.h"
+#include "GatePool.h"
+#include "NetlistOptimizer.h"
+#include "PatternSimulation.h"
+
+#include <algorithm>
+
+int ChipDefinition::truthTableInputs = CHIP_TRUTH_TABLE_MAX_INPUTS;
+
+ChipDefinition::ChipDefinition(std::vector<Gate*>* _circuit, std::string _name, GatePool* _circuitPool) {
+    circuit = _circuit;
+    circuitPool = _circuitPool;
+    name = _name;
+    netlist = optimizeNetlist(compileNetlist(*circuit)).netlist; // instances only see settled outputs
+
+    int n = netlist.gateCount();
+
+    initialState.assign((n + 63) / 64, 0);
+    allocateScratch();
+
+    for (int g = 0; g < n; g++) {
+        queued[g] = 1;
+        pending.push_back(g);
+    }
+    settle(initialState.data());
+
+    buildTruthTable();
+}
+
+ChipDefinition::ChipDefinition(const Netlist& _netlist, const std::vector<uint64_t>& _initialState, std::string _name, std::function<std::vector<Gate*>*()> _loadCircuit) {
+    circuit = nullptr;
+    circuitPool = nullptr;
+    loadCircuit = _loadCircuit;
+    name = _name;
+    netlist = _netlist;
+    initialState = _initialState;
+
+    allocateScratch();
+    buildTruthTable();
+}
+
+void ChipDefinition::allocateScratch() {
+    queued.assign(netlist.gateCount(), 0);
+}
+
+// Evaluates the netlist on every input combination, 64 at a time
+void ChipDefinition::buildTruthTable() {
+    int inputCount = getInputCount();
+    int outputCount = getOutputCount();
+
+    if (inputCount > truthTableInputs || outputCount > CHIP_TRUTH_TABLE_MAX_OUTPUTS) { return; }
+
+    PatternSimulation64 sim(netlist);
+    if (!sim.isValid()) { return; }
+
+    uint64_t total = 1ull << inputCount;
+    truthTable.assign(total, 0);
+
+    for (uint64_t first = 0; first < total; first += 64) {
+        // exhaustiveInputBits counts input 0 as the most significant bit, the table as the least
+        for (int i = 0; i < inputCount; i++) {
+            sim.setInput(i, 0, exhaustiveInputBits(inputCount - 1 - i, inputCount, first));
+        }
+
+        sim.evaluate();
+
+        int patterns = total - first < 64 ? (int)(total - first) : 64;
+        for (int o = 0; o < outputCount; o++) {
+            uint64_t bits = sim.getOutput(o, 0);
+            for (int p = 0; p < patterns; p++) {
+                truthTable[first + p] |= (uint32_t)((bits >> p) & 1) << o;
+            }
+        }
+    }
+}
+
+ChipDefinition::~ChipDefinition() {
+    if (circuitPool != nullptr) {
+        delete circuit;
+        delete circuitPool;
+    }
+}
+
+std::vector<Gate*>* ChipDefinition::getCircuit() {
+    if (circuit == nullptr) {
+        circuit = loadCircuit();
+        loadCircuit = nullptr;
+    }
+    return circuit;
+}
+
+const std::vector<int>& ChipDefinition::getOutputsReading(int index) {
+    if ((int)outputsReading.size() != getInputCount()) {
+        findOutputsReading();
+    }
+    return outputsReading[index];
+}
+
+// A walk along the fanout from each input net
+void ChipDefinition::findOutputsReading() {
+    int n = netlist.gateCount();
+
+    std::vector<std::vector<int>> outputsOfNet(n);
+    for (int o = 0; o < getOutputCount(); o++) {
+        outputsOfNet[netlist.primaryOutputs[o]].push_back(o);
+    }
+
+    outputsReading.assign(getInputCount(), std::vector<int>());
+    std::vector<char> reached;
+    std::vector<int> stack;
+
+    for (int i = 0; i < getInputCount(); i++) {
+        std::vector<int>& outputs = outputsReading[i];
+        reached.assign(n, 0);
+        stack.assign(1, netlist.primaryInputs[i]);
+        reached[netlist.primaryInputs[i]] = 1;
+
+        while (!stack.empty()) {
+            int net = stack.back();
+            stack.pop_back();
+
+            outputs.insert(outputs.end(), outputsOfNet[net].begin(), outputsOfNet[net].end());
+
+            for (int k = netlist.fanoutStart[net]; k < netlist.fanoutStart[net + 1]; k++) {
+                int g = netlist.fanout[k];
+                if (!reached[g]) {
+                    reached[g] = 1;
+                    stack.push_back(g);
+                }
+            }
+        }
+
+        std::sort(outputs.begin(), outputs.end());
+    }
+}
+
+void ChipDefinition::queueFanout(int net) {
+    for (int i = netlist.fanoutStart[net]; i < netlist.fanoutStart[net + 1]; i++) {
+        int g = netlist.fanout[i];
+        if (!queued[g]) {
+            queued[g] = 1;
+            pending.push_back(g);
+        }
+    }
+}
+
+// Same delta cycle scheme as NetlistSimulation::settle, on a packed state
+bool ChipDefinition::settle(uint64_t* state) {
+    bool settled = true;
+
+    for (int cycle = 0; !pending.empty(); cycle++) {
+        if (cycle >= CHIP_SETTLE_MAX_CYCLES) {
+            settled = false;
+            break;
+        }
+
+        wave.swap(pending);
+        pending.clear();
+        changed.clear();
+
+        for (int g : wave) {
+            queued[g] = 0;
+
+            GateType type = netlist.types[g];
+            if (type == GateType::SWITCH) { continue; }
+
+            int a = netlist.inputNet(g, 0);
+            int b = netlist.inputNet(g, 1);
+            bool va = a != -1 && getBit(state, a);
+            bool vb = b != -1 && getBit(state, b);
+
+            bool value = type == GateType::LIGHT ? va : evaluateGate(type, va, vb);
+            if (value != getBit(state, g)) {
+                changed.push_back(g);
+            }
+        }
+
+        for (int g : changed) {
+            setBit(state, g, !getBit(state, g));
+            queueFanout(g);
+        }
+    }
+
+    // an oscillating chip is left as it is, the next input change picks up from there
+    for (int g : pending) {
+        queued[g] = 0;
+    }
+    pending.clear();
+
+    return settled;
+}
+
+bool ChipDefinition::setInput(uint64_t* state, int index, bool value) {
+    int g = netlist.primaryInputs[index];
+    if (getBit(state, g) == value) { return true; }
+
+    setBit(state, g, value);
+    queueFanout(g);
+
+    return settle(state);
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "Netlist.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#define CHIP_SETTLE_MAX_CYCLES 1000
+#define CHIP_TRUTH_TABLE_MAX_INPUTS 16  // default of ChipDefinition::truthTableInputs
+#define CHIP_TRUTH_TABLE_MAX_OUTPUTS 32 // a table entry is a uint32_t
+
+class GatePool;
+
+// What every instance of a chip shares : the circuit it was loaded from (kept for saving and
+// compiling, never simulated itself) and that circuit flattened to a Netlist.
+// An instance only owns one bit of state per net, see IntegratedChip.
+//
+// A definition made by a loader owns its circuit and the GatePool of its gates, so the circuit lives
+// exactly as long as the definition, whatever happens to the pool of the board it was loaded into.
+//
+// A definition can also be made from an already compiled netlist (ChipCache.h); its circuit is then
+// only loaded the first time getCircuit is called.
+//
+// A chip without feedback loops and with few enough inputs is also compiled to a truth table : its
+// instances then only keep their input bits, and an input change is one table lookup instead of
+// settling the netlist.
+class ChipDefinition {
+private:
+    std::vector<Gate*>* circuit;
+    GatePool* circuitPool; // owned with circuit when not nullptr
+    std::function<std::vector<Gate*>*()> loadCircuit;
+
+    std::vector<uint64_t> initialState;
+    std::vector<uint32_t> truthTable; // output bits, indexed by the input bits (input i is bit i)
+    std::vector<std::vector<int>> outputsReading; // by input, filled by the first getOutputsReading
+
+    // scratch space for settle, shared by all instances (the simulation is single threaded)
+    std::vector<int> pending;
+    std::vector<int> wave;
+    std::vector<int> changed;
+    std::vector<char> queued;
+
+    void queueFanout(int net);
+    bool settle(uint64_t* state);
+    void allocateScratch();
+    void buildTruthTable();
+    void findOutputsReading();
+
+public:
+    // Largest input count compiled to a truth table (2^n entries), 0 disables them.
+    // Applies to the definitions made afterwards.
+    static int truthTableInputs;
+
+    std::string name;
+    Netlist netlist;
+
+    // With _circuitPool (the pool _circuit's gates were made in) the definition deletes both, otherwise
+    // the circuit is the caller's
+    ChipDefinition(std::vector<Gate*>* _circuit, std::string _name, GatePool* _circuitPool = nullptr);
+
+    // _initialState must be the settled power-on state of _netlist. _loadCircuit builds the circuit
+    // the netlist was compiled from.
+    ChipDefinition(const Netlist& _netlist, const std::vector<uint64_t>& _initialState, std::string _name, std::function<std::vector<Gate*>*()> _loadCircuit);
+
+    // The chips made from it, and the definitions whose circuits hold such chips, must be gone
+    ~ChipDefinition();
+
+    ChipDefinition(const ChipDefinition&) = delete;
+    ChipDefinition& operator=(const ChipDefinition&) = delete;
+
+    std::vector<Gate*>* getCircuit();
+
+    bool isCircuitLoaded() {
+        return circuit != nullptr;
+    }
+
+    int getInputCount() {
+        return (int)netlist.primaryInputs.size();
+    }
+
+    int getOutputCount() {
+        return (int)netlist.primaryOutputs.size();
+    }
+
+    int getStateWords() {
+        return (int)initialState.size();
+    }
+
+    bool hasTruthTable() {
+        return !truthTable.empty();
+    }
+
+    // Output bits (output i is bit i) for the input bits, only with a truth table
+    uint32_t lookup(uint32_t inputs) {
+        return truthTable[inputs];
+    }
+
+    // Settled power-on state, NOT gates high and everything else low
+    const std::vector<uint64_t>& getInitialState() {
+        return initialState;
+    }
+
+    static bool getBit(const uint64_t* state, int net) {
+        return (state[net >> 6] >> (net & 63)) & 1;
+    }
+
+    static void setBit(uint64_t* state, int net, bool value) {
+        if (value) {
+            state[net >> 6] |= 1ull << (net & 63);
+        }
+        else {
+            state[net >> 6] &= ~(1ull << (net & 63));
+        }
+    }
+
+    // Changes one input of an instance and lets the inside settle.
+    // Returns false if it was still changing after CHIP_SETTLE_MAX_CYCLES delta cycles.
+    bool setInput(uint64_t* state, int index, bool value);
+
+    // Outputs whose state can depend on input `index` : those the netlist reaches from it, through
+    // feedback loops too. Increasing, computed for every input on the first call.
+    const std::vector<int>& getOutputsReading(int index);
+
+    bool getOutput(const uint64_t* state, int index) {
+        return getBit(state, netlist.primaryOutputs[index]);
+    }
+};
@@ -0,0 +1,310 @@
+#include "ChipLibrary.h"
+#include "ChipCache.h"
+#include "Hash.h"
+#include "Serialization.h"
+#include "Simulation.h"
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+// Nanoseconds where stat has them, whole seconds elsewhere
+static long long modificationTime(const struct stat& info) {
+#if defined(__linux__)
+    return (long long)info.st_mtim.tv_sec * 1000000000ll + info.st_mtim.tv_nsec;
+#elif defined(__APPLE__)
+    return (long long)info.st_mtimespec.tv_sec * 1000000000ll + info.st_mtimespec.tv_nsec;
+#else
+    return (long long)info.st_mtime * 1000000000ll;
+#endif
+}
+
+static void addToken(std::string& key, const std::string& token) {
+    key += token;
+    key += ' ';
+}
+
+// Pins of a primitive gate, or of a chip made from definition
+static int inputPinCount(GateType type, ChipDefinition* definition) {
+    switch (type) {
+        case GateType::OR:
+        case GateType::AND:
+        case GateType::XOR:
+            return 2;
+        case GateType::NOT:
+        case GateType::LIGHT:
+            return 1;
+        case GateType::INTEGRATED:
+            return definition->getInputCount();
+        default:
+            return 0;
+    }
+}
+
+static int outputPinCount(GateType type, ChipDefinition* definition) {
+    switch (type) {
+        case GateType::LIGHT:
+            return 0;
+        case GateType::INTEGRATED:
+            return definition->getOutputCount();
+        default:
+            return 1;
+    }
+}
+
+// Reads one circuit of a save file back into the text loadFromFile takes, and writes its content as
+// key. Chips count by the id of their definition instead of their index in the file, so the same
+// circuit has the same key in any file.
+//
+// loadFromFile trusts its input, so everything it would index with is checked here : gate types, chip
+// circuits (definitions and chipIds go together), and the gates and pins of every connection.
+static bool readCircuit(std::istream& inputStream, const std::vector<ChipDefinition*>& definitions, const std::vector<uint64_t>& chipIds, std::string& text, std::string& key) {
+    std::ostringstream out;
+    std::map<int, std::pair<int, int>> pinCounts; // inputs and outputs by gate id
+    key.clear();
+
+    int gateCount;
+    if (!(inputStream >> gateCount) || gateCount < 0) {
+        return false;
+    }
+    out << gateCount << '\n';
+    addToken(key, std::to_string(gateCount));
+
+    for (int i = 0; i < gateCount; i++) {
+        std::string x, y;
+        int id, type;
+
+        if (!(inputStream >> id >> type) || type < 0 || type > (int)GateType::INTEGRATED || pinCounts.count(id) != 0) {
+            return false;
+        }
+        out << id << ' ' << type << ' ';
+        addToken(key, std::to_string(type));
+
+        ChipDefinition* definition = nullptr;
+        if (type == (int)GateType::INTEGRATED) {
+            int circuitID;
+            if (!(inputStream >> circuitID) || circuitID < 0 || circuitID >= (int)chipIds.size()) {
+                return false;
+            }
+            out << circuitID << ' ';
+            addToken(key, "#" + std::to_string(chipIds[circuitID]));
+            definition = definitions[circuitID];
+        }
+        pinCounts[id] = std::make_pair(inputPinCount((GateType)type, definition), outputPinCount((GateType)type, definition));
+
+        inputStream >> x >> y;
+        out << x << ' ' << y << '\n';
+        addToken(key, x);
+        addToken(key, y);
+    }
+
+    int connectionCount;
+    if (!(inputStream >> connectionCount) || connectionCount < 0) {
+        return false;
+    }
+    out << connectionCount << '\n';
+
+    for (int i = 0; i < connectionCount; i++) {
+        // input gate and pin, then output gate and pin
+        int values[4];
+        if (!(inputStream >> values[0] >> values[1] >> values[2] >> values[3])) {
+            return false;
+        }
+
+        auto input = pinCounts.find(values[0]);
+        auto output = pinCounts.find(values[2]);
+        if (input == pinCounts.end() || values[1] < 0 || values[1] >= input->second.first ||
+            output == pinCounts.end() || values[3] < 0 || values[3] >= output->second.second) {
+            return false;
+        }
+
+        out << values[0] << ' ' << values[1] << ' ' << values[2] << ' ' << values[3] << '\n';
+        for (int value : values) {
+            addToken(key, std::to_string(value));
+        }
+    }
+
+    text = out.str();
+    return (bool)inputStream;
+}
+
+ChipLibrary::ChipLibrary() {
+    nestedCount = 0;
+    hits = 0;
+    parses = 0;
+    cached = 0;
+}
+
+ChipLibrary::~ChipLibrary() {
+    // the gates go with pool
+    for (auto definition : owned) {
+        if (definition->isCircuitLoaded()) {
+            delete definition->getCircuit();
+        }
+        delete definition;
+    }
+}
+
+bool ChipLibrary::loadCircuits(std::istream& inputStream, bool recursive, std::vector<Gate*>& topLevel, GatePool* topLevelPool) {
+    int circuitCount = 1;
+    if (recursive && !(inputStream >> circuitCount)) {
+        return false;
+    }
+
+    std::vector<ChipDefinition*> definitions;
+    std::vector<uint64_t> ids;
+
+    for (int c = 0; c < circuitCount; c++) {
+        int circuitID;
+        if (recursive && !(inputStream >> circuitID)) {
+            return false;
+        }
+
+        std::string text, key;
+        if (!readCircuit(inputStream, definitions, ids, text, key)) {
+            return false;
+        }
+
+        std::istringstream section(text);
+
+        if (c == circuitCount - 1) {
+            loadFromFile(topLevel, section, &definitions, topLevelPool);
+            return true;
+        }
+
+        // the hash only narrows the search, a definition is shared when the whole content matches
+        std::vector<NestedEntry>& candidates = nested[hashBytes(FNV_OFFSET, key.data(), key.size())];
+        const NestedEntry* entry = nullptr;
+        for (const NestedEntry& candidate : candidates) {
+            if (candidate.key == key) {
+                entry = &candidate;
+                break;
+            }
+        }
+
+        if (entry == nullptr) {
+            std::vector<Gate*>* circuit = new std::vector<Gate*>();
+            Simulation::suspend();
+            loadFromFile(*circuit, section, &definitions, &pool);
+            Simulation::resume();
+
+            ChipDefinition* definition = new ChipDefinition(circuit, CHIP_LIBRARY_NESTED_NAME);
+            owned.push_back(definition);
+            candidates.push_back(NestedEntry{ key, definition, nestedCount++ });
+            entry = &candidates.back();
+        }
+
+        definitions.push_back(entry->definition);
+        ids.push_back(entry->id);
+    }
+
+    return false;
+}
+
+// nullptr when the bytes are not a valid save
+std::vector<Gate*>* ChipLibrary::parseCircuit(const std::string& bytes, bool recursive) {
+    std::vector<Gate*>* circuit = new std::vector<Gate*>();
+    std::istringstream iss(bytes);
+
+    Simulation::suspend();
+    bool loaded = loadCircuits(iss, recursive, *circuit, &pool);
+    Simulation::resume();
+
+    if (!loaded) {
+        for (auto gate : *circuit) {
+            pool.destroy(gate);
+        }
+        delete circuit;
+        return nullptr;
+    }
+
+    return circuit;
+}
+
+ChipDefinition* ChipLibrary::get(const std::string& fileName, const std::string& name, bool recursive) {
+    struct stat info;
+    if (stat(fileName.c_str(), &info) != 0) {
+        std::cerr << "cannot open " << fileName << std::endl;
+        return nullptr;
+    }
+
+    auto it = files.find(fileName);
+    bool known = it != files.end() && it->second.name == name && it->second.recursive == recursive;
+
+    if (known && it->second.modified == modificationTime(info) && it->second.size == (long long)info.st_size) {
+        hits++;
+        return it->second.definition;
+    }
+
+    std::ifstream ifs(fileName, std::ifstream::in | std::ifstream::binary);
+    if (!ifs) {
+        std::cerr << "cannot open " << fileName << std::endl;
+        return nullptr;
+    }
+
+    std::ostringstream content;
+    content << ifs.rdbuf();
+
+    std::string bytes = content.str();
+    uint64_t hash = hashBytes(FNV_OFFSET, bytes.data(), bytes.size());
+
+    if (known && it->second.hash == hash && it->second.bytes == bytes) {
+        // touched but not changed
+        it->second.modified = modificationTime(info);
+        it->second.size = (long long)info.st_size;
+        hits++;
+        return it->second.definition;
+    }
+
+    ChipDefinition* definition = nullptr;
+    uint64_t key = chipCacheKey(hash, recursive);
+
+    Netlist netlist;
+    std::vector<uint64_t> initialState;
+    if (!cacheDirectory.empty() && readChipCache(cacheDirectory, key, bytes, netlist, initialState)) {
+        // the cache entry was written after these same bytes parsed, so parsing them later succeeds
+        auto load = [this, bytes, recursive]() {
+            std::vector<Gate*>* circuit = parseCircuit(bytes, recursive);
+            return circuit != nullptr ? circuit : new std::vector<Gate*>();
+        };
+        definition = new ChipDefinition(netlist, initialState, name, load);
+        cached++;
+    }
+    else {
+        std::vector<Gate*>* circuit = parseCircuit(bytes, recursive);
+        if (circuit == nullptr) {
+            std::cerr << fileName << " is not a valid save file" << std::endl;
+            return nullptr;
+        }
+
+        definition = new ChipDefinition(circuit, name);
+        parses++;
+
+        if (!cacheDirectory.empty() && !writeChipCache(cacheDirectory, key, bytes, definition->netlist, definition->getInitialState())) {
+            std::cerr << "cannot write " << chipCachePath(cacheDirectory, key) << std::endl;
+        }
+    }
+
+    owned.push_back(definition);
+    files[fileName] = FileEntry{ name, recursive, modificationTime(info), (long long)info.st_size, hash, bytes, definition };
+
+    return definition;
+}
+
+bool ChipLibrary::load(std::vector<Gate*>& gates, const std::string& fileName, bool recursive, GatePool* gatePool) {
+    std::ifstream ifs(fileName, std::ifstream::in);
+    if (!ifs) {
+        std::cerr << "cannot open " << fileName << std::endl;
+        return false;
+    }
+
+    if (!loadCircuits(ifs, recursive, gates, gatePool)) {
+        std::cerr << fileName << " is not a valid save file" << std::endl;
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "ChipDefinition.h"
+#include "Gate.h"
+#include "GatePool.h"
+
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <string>
+#include <vector>
+
+#define CHIP_LIBRARY_NESTED_NAME "CHIP" // name of the chips nested in a save, like loadFromFileRecursively
+
+// Chip definitions loaded from save files, each one parsed once and shared by every chip placed from it.
+//
+// get checks the file's modification time and size; only when they changed is the file read again, and
+// only when its content changed (hash, then bytes) is it parsed again. Chips already placed keep the
+// definition they were made from. Where stat only has whole seconds (Windows), a change that keeps both
+// the size and the modification second is not noticed.
+//
+// Circuits nested in recursive saves are shared by content : the same sub-circuit in several files, or
+// in several loads of the board, is a single ChipDefinition. Sharing compares the whole content, two
+// circuits whose hashes collide stay two definitions.
+//
+// With a cache directory, compiled chips are also kept on disk (ChipCache.h). A file whose content is
+// in the cache is neither parsed nor compiled, its circuit is only parsed if something asks for it
+// (saving a board that holds the chip, compiling a board to a netlist).
+class ChipLibrary {
+private:
+    struct FileEntry {
+        std::string name;
+        bool recursive;
+        long long modified; // nanoseconds
+        long long size;
+        uint64_t hash;
+        std::string bytes;
+        ChipDefinition* definition;
+    };
+
+    struct NestedEntry {
+        std::string key; // content, see readCircuit
+        ChipDefinition* definition;
+        uint64_t id;     // stands for the definition in the keys of the circuits using it
+    };
+
+    std::map<std::string, FileEntry> files;
+    std::map<uint64_t, std::vector<NestedEntry>> nested; // by hash of the key
+    uint64_t nestedCount;
+    std::vector<ChipDefinition*> owned;          // every definition ever made, including replaced ones
+    std::string cacheDirectory;
+    GatePool pool; // the gates of every circuit parsed by the library
+
+    std::vector<Gate*>* parseCircuit(const std::string& bytes, bool recursive);
+    bool loadCircuits(std::istream& inputStream, bool recursive, std::vector<Gate*>& topLevel, GatePool* topLevelPool);
+
+public:
+    unsigned long long hits;    // get calls answered without parsing
+    unsigned long long parses;  // files parsed by get
+    unsigned long long cached;  // files get found compiled in the cache directory
+
+    ChipLibrary();
+
+    // Deletes every definition and its circuit, the chips placed from them must be gone
+    ~ChipLibrary();
+
+    ChipLibrary(const ChipLibrary&) = delete;
+    ChipLibrary& operator=(const ChipLibrary&) = delete;
+
+    // Empty (the default) keeps everything in memory
+    void setCacheDirectory(const std::string& directory) {
+        cacheDirectory = directory;
+    }
+
+    // Definition of the top level circuit of a save file (Ctrl+S format unless recursive).
+    // Returns nullptr if the file cannot be read or parsed.
+    ChipDefinition* get(const std::string& fileName, const std::string& name, bool recursive);
+
+    // Loads a save file like loadFromFile / loadFromFileRecursively, appending its top level circuit to
+    // gates, with the nested chips taken from the library. The top level gates are made in gatePool
+    // when one is given, else with new.
+    bool load(std::vector<Gate*>& gates, const std::string& fileName, bool recursive, GatePool* gatePool = nullptr);
+};
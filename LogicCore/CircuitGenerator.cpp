@@ -0,0 +1,439 @@
+#include "CircuitGenerator.h"
+#include "BinaryFormat.h"
+
+#include <algorithm>
+#include <random>
+
+int GeneratedCircuit::add(GateType type) {
+    types.push_back(type);
+    return (int)types.size() - 1;
+}
+
+int GeneratedCircuit::add(GateType type, int a) {
+    int gate = add(type);
+    connect(a, gate, 0);
+    return gate;
+}
+
+int GeneratedCircuit::add(GateType type, int a, int b) {
+    int gate = add(type);
+    connect(a, gate, 0);
+    connect(b, gate, 1);
+    return gate;
+}
+
+void GeneratedCircuit::connect(int source, int gate, int inputPin) {
+    connections.push_back(gate);
+    connections.push_back(inputPin);
+    connections.push_back(source);
+    connections.push_back(0); // primitives only have one output
+}
+
+static int layoutX(int gate) {
+    return (gate / GENERATOR_COLUMN_HEIGHT) * GENERATOR_SPACING_X;
+}
+
+static int layoutY(int gate) {
+    return (gate % GENERATOR_COLUMN_HEIGHT) * GENERATOR_SPACING_Y;
+}
+
+void GeneratedCircuit::write(std::ostream& outputStream) const {
+    outputStream << gateCount() << '\n';
+
+    for (int i = 0; i < gateCount(); i++) {
+        int x = layoutX(i);
+        int y = layoutY(i);
+        outputStream << i << ' ' << (int)types[i] << ' ' << x << ' ' << y << '\n';
+    }
+
+    outputStream << connectionCount() << '\n';
+
+    for (size_t i = 0; i < connections.size(); i += 4) {
+        outputStream << connections[i] << ' ' << connections[i + 1] << ' ' << connections[i + 2] << ' ' << connections[i + 3] << '\n';
+    }
+}
+
+void GeneratedCircuit::writeRecursive(std::ostream& outputStream) const {
+    outputStream << 1 << '\n' << 0 << '\n';
+    write(outputStream);
+}
+
+void GeneratedCircuit::writeBinary(std::ostream& outputStream) const {
+    std::vector<BinaryCircuitData> circuits(1);
+    BinaryCircuitData& data = circuits[0];
+
+    data.types.reserve(types.size());
+    data.positions.reserve(types.size() * 2);
+    for (int i = 0; i < gateCount(); i++) {
+        data.types.push_back((uint8_t)types[i]);
+        data.positions.push_back((float)layoutX(i));
+        data.positions.push_back((float)layoutY(i));
+    }
+    data.connections.assign(connections.begin(), connections.end());
+
+    ::writeBinary(outputStream, circuits);
+}
+
+static void halfAdder(GeneratedCircuit& c, int a, int b, int& sum, int& carry) {
+    sum = c.add(GateType::XOR, a, b);
+    carry = c.add(GateType::AND, a, b);
+}
+
+static void fullAdder(GeneratedCircuit& c, int a, int b, int carryIn, int& sum, int& carryOut) {
+    int axb = c.add(GateType::XOR, a, b);
+    sum = c.add(GateType::XOR, axb, carryIn);
+    carryOut = c.add(GateType::OR, c.add(GateType::AND, a, b), c.add(GateType::AND, axb, carryIn));
+}
+
+// Balanced tree of 2 input gates over nets, returns the root
+static int gateTree(GeneratedCircuit& c, GateType type, std::vector<int> nets) {
+    while (nets.size() > 1) {
+        std::vector<int> next;
+        for (size_t i = 0; i + 1 < nets.size(); i += 2) {
+            next.push_back(c.add(type, nets[i], nets[i + 1]));
+        }
+        if (nets.size() % 2 == 1) {
+            next.push_back(nets.back());
+        }
+        nets.swap(next);
+    }
+    return nets[0];
+}
+
+static void addLights(GeneratedCircuit& c, const std::vector<int>& nets) {
+    for (int net : nets) {
+        if (net == -1) {
+            c.add(GateType::LIGHT); // unconnected, reads 0
+        }
+        else {
+            c.add(GateType::LIGHT, net);
+        }
+    }
+}
+
+// Enable of a D latch, with the two delayed copies the latch needs
+struct LatchEnable {
+    int inverted; // one gate delay after the enable
+    int buffered; // two gate delays after the enable
+};
+
+static LatchEnable latchEnable(GeneratedCircuit& c, int enable) {
+    LatchEnable e;
+    e.inverted = c.add(GateType::NOT, enable);
+    e.buffered = c.add(GateType::NOT, e.inverted);
+    return e;
+}
+
+// q = (d & enable) | (q & !enable). The hold term reads the enable one gate delay before the load term,
+// so when the enable falls the hold term is up before the load term drops and q does not glitch
+// (with both on the same delay the latch oscillates in the delta cycle simulation).
+static int dLatch(GeneratedCircuit& c, int d, const LatchEnable& e) {
+    int q = c.add(GateType::OR);
+    int load = c.add(GateType::AND, d, e.buffered);
+    int hold = c.add(GateType::AND, q, e.inverted);
+    c.connect(load, q, 0);
+    c.connect(hold, q, 1);
+    return q;
+}
+
+// Master / slave pair sharing the clock enables of every flip-flop
+struct Clock {
+    LatchEnable master; // open while the clock is low
+    LatchEnable slave;  // open while the clock is high
+};
+
+static Clock clockEnables(GeneratedCircuit& c, int clk) {
+    Clock clock;
+    clock.master = latchEnable(c, c.add(GateType::NOT, clk));
+    clock.slave = latchEnable(c, clk);
+    return clock;
+}
+
+// Rising edge triggered D flip-flop. d is connected later with connect(d, input, 0), so the flip-flops
+// can feed their own next state logic. Returns q, sets input to the gate d must drive.
+static int dFlipFlop(GeneratedCircuit& c, const Clock& clock, int& input) {
+    int master = c.add(GateType::OR);
+    input = c.add(GateType::AND);
+    c.connect(clock.master.buffered, input, 1);
+    int hold = c.add(GateType::AND, master, clock.master.inverted);
+    c.connect(input, master, 0);
+    c.connect(hold, master, 1);
+
+    return dLatch(c, master, clock.slave);
+}
+
+void generateRippleAdder(GeneratedCircuit& circuit, int bits) {
+    std::vector<int> a, b, sums;
+
+    for (int i = 0; i < bits; i++) {
+        a.push_back(circuit.add(GateType::SWITCH));
+        b.push_back(circuit.add(GateType::SWITCH));
+    }
+    int carry = circuit.add(GateType::SWITCH);
+
+    for (int i = 0; i < bits; i++) {
+        int sum;
+        fullAdder(circuit, a[i], b[i], carry, sum, carry);
+        sums.push_back(sum);
+    }
+
+    sums.push_back(carry);
+    addLights(circuit, sums);
+}
+
+void generateCarryLookaheadAdder(GeneratedCircuit& circuit, int bits) {
+    std::vector<int> a, b, sums;
+
+    for (int i = 0; i < bits; i++) {
+        a.push_back(circuit.add(GateType::SWITCH));
+        b.push_back(circuit.add(GateType::SWITCH));
+    }
+    int carry = circuit.add(GateType::SWITCH);
+
+    for (int base = 0; base < bits; base += 4) {
+        int size = std::min(4, bits - base);
+        std::vector<int> g, p;
+
+        for (int i = 0; i < size; i++) {
+            g.push_back(circuit.add(GateType::AND, a[base + i], b[base + i]));
+            p.push_back(circuit.add(GateType::XOR, a[base + i], b[base + i]));
+        }
+
+        // c(k) = g(k-1) | p(k-1) g(k-2) | ... | p(k-1) .. p(0) c(0)
+        std::vector<int> carries(1, carry);
+        for (int k = 1; k <= size; k++) {
+            std::vector<int> terms;
+            for (int j = k - 1; j >= -1; j--) {
+                std::vector<int> term;
+                for (int m = k - 1; m > j; m--) {
+                    term.push_back(p[m]);
+                }
+                term.push_back(j >= 0 ? g[j] : carries[0]);
+                terms.push_back(gateTree(circuit, GateType::AND, term));
+            }
+            carries.push_back(gateTree(circuit, GateType::OR, terms));
+        }
+
+        for (int i = 0; i < size; i++) {
+            sums.push_back(circuit.add(GateType::XOR, p[i], carries[i]));
+        }
+
+        carry = carries[size];
+    }
+
+    sums.push_back(carry);
+    addLights(circuit, sums);
+}
+
+void generateArrayMultiplier(GeneratedCircuit& circuit, int bits) {
+    std::vector<int> a, b;
+
+    for (int i = 0; i < bits; i++) {
+        a.push_back(circuit.add(GateType::SWITCH));
+    }
+    for (int i = 0; i < bits; i++) {
+        b.push_back(circuit.add(GateType::SWITCH));
+    }
+
+    std::vector<int> product(2 * bits, -1); // -1 : still 0
+
+    for (int j = 0; j < bits; j++) {
+        int carry = -1;
+
+        for (int i = 0; i < bits; i++) {
+            int k = i + j;
+            int partial = circuit.add(GateType::AND, a[i], b[j]);
+
+            if (product[k] == -1 && carry == -1) {
+                product[k] = partial;
+            }
+            else if (product[k] == -1 || carry == -1) {
+                int other = product[k] == -1 ? carry : product[k];
+                halfAdder(circuit, other, partial, product[k], carry);
+            }
+            else {
+                fullAdder(circuit, product[k], partial, carry, product[k], carry);
+            }
+        }
+
+        for (int k = j + bits; carry != -1; k++) {
+            if (product[k] == -1) {
+                product[k] = carry;
+                carry = -1;
+            }
+            else {
+                halfAdder(circuit, product[k], carry, product[k], carry);
+            }
+        }
+    }
+
+    addLights(circuit, product);
+}
+
+// Taps of maximal length LFSRs (Xilinx XAPP 052), other widths use n, n-1
+static std::vector<int> lfsrTaps(int bits) {
+    switch (bits) {
+        case 3: return { 3, 2 };
+        case 4: return { 4, 3 };
+        case 5: return { 5, 3 };
+        case 6: return { 6, 5 };
+        case 7: return { 7, 6 };
+        case 8: return { 8, 6, 5, 4 };
+        case 16: return { 16, 15, 13, 4 };
+        case 32: return { 32, 22, 2, 1 };
+        case 64: return { 64, 63, 61, 60 };
+        default: return { bits, bits - 1 };
+    }
+}
+
+void generateLfsr(GeneratedCircuit& circuit, int bits) {
+    int clk = circuit.add(GateType::SWITCH);
+    int seed = circuit.add(GateType::SWITCH);
+
+    Clock clock = clockEnables(circuit, clk);
+
+    std::vector<int> q(bits), inputs(bits);
+    for (int i = 0; i < bits; i++) {
+        q[i] = dFlipFlop(circuit, clock, inputs[i]);
+    }
+
+    std::vector<int> feedback(1, seed);
+    for (int tap : lfsrTaps(bits)) {
+        if (tap >= 1 && tap <= bits) {
+            feedback.push_back(q[tap - 1]);
+        }
+    }
+    circuit.connect(gateTree(circuit, GateType::XOR, feedback), inputs[0], 0);
+
+    for (int i = 1; i < bits; i++) {
+        circuit.connect(q[i - 1], inputs[i], 0);
+    }
+
+    addLights(circuit, q);
+}
+
+void generateCounter(GeneratedCircuit& circuit, int bits) {
+    int clk = circuit.add(GateType::SWITCH);
+    int carry = circuit.add(GateType::SWITCH); // enable
+
+    Clock clock = clockEnables(circuit, clk);
+
+    std::vector<int> q(bits);
+    for (int i = 0; i < bits; i++) {
+        int input;
+        q[i] = dFlipFlop(circuit, clock, input);
+
+        circuit.connect(circuit.add(GateType::XOR, q[i], carry), input, 0);
+        carry = circuit.add(GateType::AND, q[i], carry);
+    }
+
+    addLights(circuit, q);
+}
+
+// One net per register, high when the address switches hold its index
+static std::vector<int> addressDecoder(GeneratedCircuit& c, const std::vector<int>& address, int registers) {
+    std::vector<int> inverted;
+    for (int bit : address) {
+        inverted.push_back(c.add(GateType::NOT, bit));
+    }
+
+    std::vector<int> selects;
+    for (int r = 0; r < registers; r++) {
+        std::vector<int> literals;
+        for (size_t i = 0; i < address.size(); i++) {
+            literals.push_back(((r >> i) & 1) ? address[i] : inverted[i]);
+        }
+        selects.push_back(gateTree(c, GateType::AND, literals));
+    }
+    return selects;
+}
+
+void generateRegisterFile(GeneratedCircuit& circuit, int registers, int bits) {
+    int addressBits = 1;
+    while ((1 << addressBits) < registers) {
+        addressBits++;
+    }
+
+    std::vector<int> data, writeAddress, readAddress;
+    for (int i = 0; i < bits; i++) {
+        data.push_back(circuit.add(GateType::SWITCH));
+    }
+    for (int i = 0; i < addressBits; i++) {
+        writeAddress.push_back(circuit.add(GateType::SWITCH));
+    }
+    int writeEnable = circuit.add(GateType::SWITCH);
+    for (int i = 0; i < addressBits; i++) {
+        readAddress.push_back(circuit.add(GateType::SWITCH));
+    }
+
+    std::vector<int> writeSelects = addressDecoder(circuit, writeAddress, registers);
+    std::vector<int> readSelects = addressDecoder(circuit, readAddress, registers);
+
+    std::vector<std::vector<int>> readTerms(bits);
+
+    for (int r = 0; r < registers; r++) {
+        LatchEnable enable = latchEnable(circuit, circuit.add(GateType::AND, writeSelects[r], writeEnable));
+
+        for (int i = 0; i < bits; i++) {
+            int q = dLatch(circuit, data[i], enable);
+            readTerms[i].push_back(circuit.add(GateType::AND, q, readSelects[r]));
+        }
+    }
+
+    std::vector<int> outputs;
+    for (int i = 0; i < bits; i++) {
+        outputs.push_back(gateTree(circuit, GateType::OR, readTerms[i]));
+    }
+
+    addLights(circuit, outputs);
+}
+
+void generateRandomDag(GeneratedCircuit& circuit, int inputs, int gates, int window, int maxFanout, uint32_t seed) {
+    static const GateType gateTypes[] = { GateType::OR, GateType::AND, GateType::XOR, GateType::NOT };
+
+    std::mt19937 rng(seed);
+    std::vector<int> fanout;
+
+    for (int i = 0; i < inputs; i++) {
+        circuit.add(GateType::SWITCH);
+        fanout.push_back(0);
+    }
+
+    auto pickSource = [&](int exclude) {
+        int count = (int)fanout.size();
+        int first = std::max(0, count - window);
+        int net = first;
+
+        for (int attempt = 0; attempt < 4; attempt++) {
+            net = first + (int)(rng() % (uint32_t)(count - first));
+            if (net != exclude && fanout[net] < maxFanout) {
+                break;
+            }
+        }
+
+        fanout[net]++;
+        return net;
+    };
+
+    for (int g = 0; g < gates; g++) {
+        GateType type = gateTypes[rng() % 4];
+
+        int a = pickSource(-1);
+        if (type == GateType::NOT) {
+            circuit.add(type, a);
+        }
+        else {
+            circuit.add(type, a, pickSource(a));
+        }
+        fanout.push_back(0);
+    }
+
+    std::vector<int> unread;
+    for (int net = inputs; net < inputs + gates; net++) {
+        if (fanout[net] == 0) {
+            unread.push_back(net);
+        }
+    }
+
+    addLights(circuit, unread);
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Gate.h"
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#define GENERATOR_COLUMN_HEIGHT 64 // gates per column when laying out a generated circuit
+#define GENERATOR_SPACING_X 80
+#define GENERATOR_SPACING_Y 40
+
+// A flat circuit of primitive gates that is written straight to the save file format, without
+// creating gate objects, so circuits of millions of gates can be generated in seconds.
+// Switches and lights keep their creation order, which is the input / output order of the circuit.
+class GeneratedCircuit {
+public:
+    std::vector<GateType> types;
+    std::vector<int> connections; // 4 per connection, in save file order : gate, input pin, source gate, output pin
+
+    int gateCount() const {
+        return (int)types.size();
+    }
+
+    int connectionCount() const {
+        return (int)connections.size() / 4;
+    }
+
+    // Returns the index of the new gate
+    int add(GateType type);
+    int add(GateType type, int a);
+    int add(GateType type, int a, int b);
+
+    void connect(int source, int gate, int inputPin);
+
+    // Ctrl+S format (loadFromFile)
+    void write(std::ostream& outputStream) const;
+
+    // saveToFileRecursively format, a single top level circuit (loadFromFileRecursively)
+    void writeRecursive(std::ostream& outputStream) const;
+
+    // Binary save file (BinaryFormat.h), the output stream must be binary
+    void writeBinary(std::ostream& outputStream) const;
+};
+
+// a0 b0 a1 b1 ... cin -> s0 s1 ... cout
+void generateRippleAdder(GeneratedCircuit& circuit, int bits);
+
+// Same pins as the ripple adder. Carries are computed by two-level lookahead inside groups of 4 bits,
+// groups ripple into each other.
+void generateCarryLookaheadAdder(GeneratedCircuit& circuit, int bits);
+
+// a0 .. a(n-1) b0 .. b(n-1) -> p0 .. p(2n-1), partial products summed row by row with ripple adders
+void generateArrayMultiplier(GeneratedCircuit& circuit, int bits);
+
+// The sequential circuits are built from D latches of primitive gates. Change their data / address inputs
+// while clk (or we) is steady : changing both in the same step violates setup time, and a latch caught
+// in the middle oscillates under delta cycle simulation.
+
+// Fibonacci LFSR of edge triggered flip-flops. clk seed -> q0 .. q(n-1)
+// seed is XORed into the feedback, so a register that is all zero can be started.
+void generateLfsr(GeneratedCircuit& circuit, int bits);
+
+// Synchronous binary counter. clk enable -> q0 .. q(n-1)
+void generateCounter(GeneratedCircuit& circuit, int bits);
+
+// registers x bits of D latches with one write and one read port.
+// d0 .. d(bits-1) waddr... we raddr... -> q0 .. q(bits-1), addresses LSB first
+void generateRegisterFile(GeneratedCircuit& circuit, int registers, int bits);
+
+// inputs switches followed by gates random OR / AND / XOR / NOT gates. Each gate reads nets from the
+// `window` nets created before it and a net feeds at most maxFanout gates when there is a choice.
+// Every net nobody reads ends in a light. The logic depth grows as gates / window, a large window
+// gives a wide and shallow circuit.
+void generateRandomDag(GeneratedCircuit& circuit, int inputs, int gates, int window, int maxFanout, uint32_t seed);
@@ -0,0 +1,220 @@
+#include "EventScheduler.h"
+#include "WaveformRecorder.h"
+
+#include <algorithm>
+#include <iostream>
+
+TimingWheel::TimingWheel() {
+    freeList = -1;
+    count = 0;
+    for (auto& b : buckets) {
+        b = -1;
+    }
+}
+
+void TimingWheel::schedule(SimTime time, int net, bool value) {
+    int index;
+    if (freeList != -1) {
+        index = freeList;
+        freeList = pool[index].next;
+    }
+    else {
+        index = (int)pool.size();
+        pool.emplace_back();
+    }
+
+    ScheduledEvent& e = pool[index];
+    e.time = time;
+    e.net = net;
+    e.value = value;
+
+    int& bucket = buckets[time & (TIMING_WHEEL_SIZE - 1)];
+    e.next = bucket;
+    bucket = index;
+
+    count++;
+}
+
+void TimingWheel::takeDue(SimTime time, std::vector<ScheduledEvent>& out) {
+    size_t first = out.size();
+
+    int* link = &buckets[time & (TIMING_WHEEL_SIZE - 1)];
+    while (*link != -1) {
+        int index = *link;
+        ScheduledEvent& e = pool[index];
+
+        if (e.time == time) {
+            out.push_back(e);
+            *link = e.next;
+            e.next = freeList;
+            freeList = index;
+            count--;
+        }
+        else {
+            link = &e.next;
+        }
+    }
+
+    // buckets are LIFO, keep scheduling order so later events for a net win
+    std::reverse(out.begin() + first, out.end());
+}
+
+bool TimingWheel::nextTime(SimTime from, SimTime& out) {
+    if (count == 0) { return false; }
+
+    for (SimTime t = from; t < from + TIMING_WHEEL_SIZE; t++) {
+        for (int i = buckets[t & (TIMING_WHEEL_SIZE - 1)]; i != -1; i = pool[i].next) {
+            if (pool[i].time == t) {
+                out = t;
+                return true;
+            }
+        }
+    }
+
+    // only far future events left, find the earliest one
+    bool found = false;
+    for (int b = 0; b < TIMING_WHEEL_SIZE; b++) {
+        for (int i = buckets[b]; i != -1; i = pool[i].next) {
+            if (!found || pool[i].time < out) {
+                out = pool[i].time;
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+EventSimulation::EventSimulation(const Netlist& _netlist, const GateDelays& _delays) : netlist(_netlist), delays(_delays) {
+    int n = netlist.gateCount();
+
+    currentTime = 0;
+    eventsProcessed = 0;
+    gateEvaluations = 0;
+    recorder = nullptr;
+
+    netStates.assign(n, 0);
+    projected.assign(n, 0);
+    evaluatedAt.assign(n, (SimTime)-1);
+
+    for (auto& d : delays.delays) {
+        if (d < 0) {
+            std::cerr << "negative gate delay " << d << ", using 0" << std::endl;
+            d = 0;
+        }
+    }
+
+    // evaluate everything once, so NOT gates start high like their object counterparts
+    for (int g = 0; g < n; g++) {
+        evaluate(g);
+    }
+}
+
+void EventSimulation::evaluate(int gate) {
+    GateType type = netlist.types[gate];
+    if (type == GateType::SWITCH) { return; }
+
+    gateEvaluations++;
+
+    int a = netlist.inputNet(gate, 0);
+    int b = netlist.inputNet(gate, 1);
+    bool va = a != -1 && netStates[a];
+    bool vb = b != -1 && netStates[b];
+
+    bool value = type == GateType::LIGHT ? va : evaluateGate(type, va, vb);
+    if (value != (projected[gate] != 0)) {
+        projected[gate] = value;
+        wheel.schedule(currentTime + delays[type], gate, value);
+    }
+}
+
+void EventSimulation::queueFanout(int net) {
+    for (int i = netlist.fanoutStart[net]; i < netlist.fanoutStart[net + 1]; i++) {
+        int g = netlist.fanout[i];
+        if (evaluatedAt[g] != currentTime) {
+            evaluatedAt[g] = currentTime;
+            toEvaluate.push_back(g);
+        }
+    }
+}
+
+// Returns false when the time step is still not drained after MAX_DELTA_CYCLES (a loop of zero delay
+// gates), its remaining events are left pending
+bool EventSimulation::processTime(SimTime time) {
+    currentTime = time;
+
+    // zero delay gates schedule into the current time again, so loop until this time step is drained
+    for (int cycle = 0; ; cycle++) {
+        if (cycle >= MAX_DELTA_CYCLES) {
+            return false;
+        }
+
+        due.clear();
+        wheel.takeDue(time, due);
+        if (due.empty()) { return true; }
+
+        toEvaluate.clear();
+        for (auto& e : due) {
+            eventsProcessed++;
+            if (netStates[e.net] != (char)e.value) {
+                netStates[e.net] = e.value;
+                queueFanout(e.net);
+
+                if (recorder != nullptr && netSignals[e.net] != -1) {
+                    recorder->change(time, netSignals[e.net], e.value);
+                }
+            }
+        }
+
+        for (int g : toEvaluate) {
+            evaluatedAt[g] = (SimTime)-1;
+        }
+        for (int g : toEvaluate) {
+            evaluate(g);
+        }
+    }
+}
+
+void EventSimulation::setInput(int index, bool state) {
+    int g = netlist.primaryInputs[index];
+    if (projected[g] == (char)state) { return; }
+
+    projected[g] = state;
+    wheel.schedule(currentTime, g, state);
+}
+
+void EventSimulation::record(WaveformRecorder* _recorder, const std::vector<int>& _netSignals) {
+    recorder = _recorder;
+    netSignals = _netSignals;
+}
+
+bool EventSimulation::getOutput(int index) {
+    return netStates[netlist.primaryOutputs[index]] != 0;
+}
+
+bool EventSimulation::runUntil(SimTime t) {
+    SimTime next;
+    while (wheel.nextTime(currentTime, next) && next <= t) {
+        if (!processTime(next)) {
+            return false;
+        }
+    }
+    currentTime = t;
+    return true;
+}
+
+bool EventSimulation::settle(SimTime limit) {
+    SimTime end = currentTime + limit;
+
+    SimTime next;
+    while (wheel.nextTime(currentTime, next)) {
+        if (next > end) {
+            currentTime = end;
+            return false;
+        }
+        if (!processTime(next)) {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "Netlist.h"
+
+#include <cstdint>
+#include <vector>
+
+typedef uint64_t SimTime;
+
+class WaveformRecorder;
+
+// Propagation delay per gate type, in simulation time units. Unit delay by default. Delays must not be
+// negative : an event cannot be scheduled before the current time.
+struct GateDelays {
+    int delays[(int)GateType::INTEGRATED + 1];
+
+    GateDelays() {
+        for (auto& d : delays) {
+            d = 1;
+        }
+        delays[(int)GateType::SWITCH] = 0;
+        delays[(int)GateType::LIGHT] = 0;
+    }
+
+    int& operator[](GateType type) {
+        return delays[(int)type];
+    }
+
+    int operator[](GateType type) const {
+        return delays[(int)type];
+    }
+};
+
+struct ScheduledEvent {
+    SimTime time;
+    int net;
+    int next; // next event in the same bucket, or free list link
+    bool value;
+};
+
+#define TIMING_WHEEL_SIZE 256 // must be a power of two
+#define MAX_DELTA_CYCLES 100000 // per time step, a zero delay loop that runs longer is reported as oscillating
+
+// Hashed timing wheel : bucket (time % size) holds a linked list of events from a shared pool.
+// Events further away than one revolution just stay in their bucket until their turn comes.
+class TimingWheel {
+private:
+    std::vector<ScheduledEvent> pool;
+    int freeList;
+    int buckets[TIMING_WHEEL_SIZE];
+    int count;
+
+public:
+    TimingWheel();
+
+    void schedule(SimTime time, int net, bool value);
+
+    // Moves the events due at exactly `time` to `out` (as net/value pairs in the pool's order of insertion).
+    void takeDue(SimTime time, std::vector<ScheduledEvent>& out);
+
+    // Earliest pending event time, scanning at most one revolution from `from`. Returns false if empty.
+    bool nextTime(SimTime from, SimTime& out);
+
+    int size() {
+        return count;
+    }
+};
+
+// Discrete-event simulation of a Netlist with per gate type delays (transport delay model).
+class EventSimulation {
+private:
+    const Netlist& netlist;
+    GateDelays delays;
+    TimingWheel wheel;
+    SimTime currentTime;
+
+    std::vector<char> projected;   // value each net will have once its pending events fire
+    std::vector<SimTime> evaluatedAt;
+    std::vector<int> toEvaluate;
+    std::vector<ScheduledEvent> due;
+
+    WaveformRecorder* recorder;
+    std::vector<int> netSignals;
+
+    void evaluate(int gate);
+    void queueFanout(int net);
+    bool processTime(SimTime time);
+
+public:
+    std::vector<char> netStates;
+
+    uint64_t eventsProcessed;
+    uint64_t gateEvaluations;
+
+    EventSimulation(const Netlist& _netlist, const GateDelays& _delays = GateDelays());
+
+    // Input changes take effect at the current time.
+    void setInput(int index, bool state);
+    bool getOutput(int index);
+
+    // Processes every event up to and including time t, then sets the clock to t. Returns false when a
+    // zero delay loop kept a time step from settling (MAX_DELTA_CYCLES), the clock then stays on that step.
+    bool runUntil(SimTime t);
+
+    // Runs until no events are pending or `limit` time units have passed. Returns false on the limit,
+    // or when a zero delay loop keeps a time step from settling.
+    bool settle(SimTime limit);
+
+    bool idle() {
+        return wheel.size() == 0;
+    }
+
+    SimTime now() {
+        return currentTime;
+    }
+
+    // Sends every change of a net with a signal (see addNetlistSignals) to recorder, null to stop.
+    void record(WaveformRecorder* _recorder, const std::vector<int>& _netSignals);
+};
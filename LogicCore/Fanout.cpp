@@ -0,0 +1,108 @@
+#include "Fanout.h"
+#include "Pin.h"
+
+FanoutTable::FanoutTable() {
+    garbage = 0;
+}
+
+void FanoutTable::reset() {
+    lists.clear();
+    freeLists.clear();
+    targets.clear();
+    garbage = 0;
+}
+
+int FanoutTable::addList() {
+    int list;
+    if (freeLists.empty()) {
+        list = (int)lists.size();
+        lists.push_back(List{ 0, 0, 0 });
+    }
+    else {
+        list = freeLists.back();
+        freeLists.pop_back();
+    }
+
+    lists[list].begin = (uint32_t)targets.size();
+    lists[list].count = 0;
+    lists[list].capacity = 0;
+    return list;
+}
+
+void FanoutTable::releaseList(int list) {
+    garbage += lists[list].capacity;
+    lists[list] = List{ 0, 0, 0 };
+    freeLists.push_back(list);
+}
+
+// Moves the list to the end of targets with room for twice its entries
+void FanoutTable::grow(int list) {
+    List& l = lists[list];
+    uint32_t capacity = l.capacity < FANOUT_SLACK ? FANOUT_SLACK : l.capacity * 2;
+    uint32_t begin = (uint32_t)targets.size();
+
+    targets.resize(targets.size() + capacity, nullptr);
+    for (uint32_t i = 0; i < l.count; i++) {
+        targets[begin + i] = targets[l.begin + i];
+    }
+
+    garbage += l.capacity;
+    l.begin = begin;
+    l.capacity = capacity;
+}
+
+void FanoutTable::compact() {
+    std::vector<Pin*> packed;
+    packed.reserve(targets.size() - garbage + lists.size() * FANOUT_SLACK);
+
+    for (List& l : lists) {
+        if (l.capacity == 0) { continue; } // free, or never added to
+
+        uint32_t begin = (uint32_t)packed.size();
+        packed.insert(packed.end(), targets.begin() + l.begin, targets.begin() + l.begin + l.count);
+        packed.resize(packed.size() + FANOUT_SLACK, nullptr);
+
+        l.begin = begin;
+        l.capacity = l.count + FANOUT_SLACK;
+    }
+
+    targets.swap(packed);
+    garbage = 0;
+}
+
+void FanoutTable::add(int list, Pin* pin) {
+    if (lists[list].count == lists[list].capacity) {
+        if (garbage > targets.size() / 2) {
+            compact();
+        }
+        if (lists[list].count == lists[list].capacity) {
+            grow(list);
+        }
+    }
+
+    List& l = lists[list];
+    pin->fanoutSlot = (int)l.count;
+    targets[l.begin + l.count] = pin;
+    l.count++;
+}
+
+void FanoutTable::remove(int list, Pin* pin) {
+    List& l = lists[list];
+    uint32_t slot = (uint32_t)pin->fanoutSlot;
+
+    Pin* last = targets[l.begin + l.count - 1];
+    targets[l.begin + slot] = last;
+    last->fanoutSlot = (int)slot;
+
+    targets[l.begin + l.count - 1] = nullptr;
+    l.count--;
+    pin->fanoutSlot = -1;
+}
+
+void FanoutTable::clear(int list) {
+    for (uint32_t i = 0; i < lists[list].count; i++) {
+        targets[lists[list].begin + i]->fanoutSlot = -1;
+        targets[lists[list].begin + i] = nullptr;
+    }
+    lists[list].count = 0;
+}
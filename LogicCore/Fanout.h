@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Pin;
+
+#define FANOUT_SLACK 2 // free entries kept behind each list when compacting, so most connects stay in place
+
+// The input pins each output pin of a circuit drives : one array holding every list, each output pin
+// owning a slice [begin, begin + count) of it (compressed sparse row, with slack). Propagation walks a
+// pin's slice straight through.
+//
+// Every GatePool owns one, for the output pins of its gates, so a board's lists go with the board and
+// circuits in separate pools share nothing. Gates made with new use Pin::defaultFanout. Not thread safe :
+// one table is only edited by one thread at a time.
+//
+// Edits are O(1) :
+// - add writes into the slack behind the slice, or moves the slice to the end of the array with twice
+//   the room (the old place becomes garbage)
+// - remove swaps the last entry into the removed one, using the slot the input pin keeps, so the order
+//   of a list is not its connection order
+// Once garbage outweighs the live entries, compact rewrites the array in list order, which keeps the
+// lists of pins made together (a load) next to each other. Its cost is spread over the edits that
+// made the garbage.
+class FanoutTable {
+private:
+    struct List {
+        uint32_t begin;
+        uint32_t count;
+        uint32_t capacity;
+    };
+
+    std::vector<List> lists;
+    std::vector<int> freeLists;
+    std::vector<Pin*> targets;
+    size_t garbage; // entries of targets no list uses
+
+    void grow(int list);
+    void compact();
+
+public:
+    FanoutTable();
+
+    // Drops every list, keeping the memory for the next circuit. No pin may use the table any more.
+    void reset();
+
+    int addList();
+
+    // The pins still listed are not told, the list must be empty or its pins gone as well
+    void releaseList(int list);
+
+    // Sets pin->fanoutSlot
+    void add(int list, Pin* pin);
+    void remove(int list, Pin* pin);
+    void clear(int list);
+
+    Pin* const* begin(int list) const {
+        return targets.data() + lists[list].begin;
+    }
+
+    Pin* const* end(int list) const {
+        return targets.data() + lists[list].begin + lists[list].count;
+    }
+
+    uint32_t size(int list) const {
+        return lists[list].count;
+    }
+};
+
+// What Pin::getFanout returns, for range-for. Only valid until the next edit of the table.
+struct FanoutRange {
+    Pin* const* first;
+    Pin* const* last;
+
+    Pin* const* begin() const {
+        return first;
+    }
+
+    Pin* const* end() const {
+        return last;
+    }
+
+    size_t size() const {
+        return (size_t)(last - first);
+    }
+};
@@ -0,0 +1,3 @@
+#include "Gate.h"
+
+Switch* Switch::clickedOn = nullptr;
@@ -0,0 +1,295 @@
+#pragma once
+
+#include "Pin.h"
+#include "Vec2.h"
+
+#include <string>
+
+enum class GateType {
+    OR,
+    AND,
+    NOT,
+    XOR,
+    SWITCH,
+    LIGHT,
+    INTEGRATED
+};
+
+// Logical part of a gate : pins, state and board position.
+// Everything visual lives in the GUI (see RetroPool/GateView.h), so the core builds without SFML.
+class Gate {
+protected:
+    Vec2f pos;
+
+public:
+    int poolSlot = -1; // slot in the GatePool that made the gate, -1 for gates made with new
+    FanoutTable* fanout = Pin::defaultFanout; // lists of the output pins, the table of the GatePool that made the gate
+
+    virtual ~Gate() {}
+
+    virtual void updateState(Pin * updatedPin) = 0;
+    virtual GateType getGateType() = 0;
+
+    virtual int getInputPinCount() = 0;
+    virtual int getOutputPinCount() = 0;
+
+    virtual Pin* getInputPins() = 0;
+    virtual Pin* getOutputPins() = 0;
+
+    virtual void position(Vec2f p) {
+        pos = p;
+    }
+
+    Vec2f getPosition() {
+        return pos;
+    }
+
+    virtual bool getPinIndex(Pin* pin, PinType pt, int& outIndex) {
+        if (pt == PinType::Input) {
+            int c = getInputPinCount();
+            Pin* pins = getInputPins();
+            for (int i = 0; i < c; i++) {
+                if ((pins+i) == pin) {
+                    outIndex = i;
+                    return true;
+                }
+            }
+        }
+        else if (pt == PinType::Output) {
+            int c = getOutputPinCount();
+            Pin* pins = getOutputPins();
+            for (int i = 0; i < c; i++) {
+                if ((pins+i) == pin) {
+                    outIndex = i;
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    };
+
+    virtual Pin* getPinByIndex(PinType pt, int index) {
+        if (pt == PinType::Input) {
+            int c = getInputPinCount();
+            Pin* pins = getInputPins();
+
+            if (index >= 0 && index < c) {
+                return pins + index;
+            }
+        }
+        else if (pt == PinType::Output) {
+            int c = getOutputPinCount();
+            Pin* pins = getOutputPins();
+            if (index >= 0 && index < c) {
+                return pins + index;
+            }
+        }
+
+        return nullptr;
+    }
+};
+
+// Two-input, one-output primitive. Subclasses only provide the boolean function.
+class BinaryGate : public Gate {
+protected:
+    Pin inputPins[2];
+    Pin outputPins[1];
+
+public:
+    BinaryGate() {
+        outputPins[0].pinType = PinType::Output;
+
+        inputPins[0].parentGate = this;
+        inputPins[1].parentGate = this;
+        outputPins[0].parentGate = this;
+    }
+
+    int getInputPinCount() {
+        return 2;
+    }
+
+    int getOutputPinCount() {
+        return 1;
+    }
+
+    Pin* getInputPins() {
+        return inputPins;
+    }
+
+    Pin* getOutputPins() {
+        return outputPins;
+    }
+};
+
+class ORGate : public BinaryGate {
+public:
+    void updateState(Pin* updatedPin) {
+        outputPins[0].update(inputPins[0].cachedState || inputPins[1].cachedState);
+    }
+
+    GateType getGateType() {
+        return GateType::OR;
+    }
+};
+
+class ANDGate : public BinaryGate {
+public:
+    void updateState(Pin* updatedPin) {
+        outputPins[0].update(inputPins[0].cachedState && inputPins[1].cachedState);
+    }
+
+    GateType getGateType() {
+        return GateType::AND;
+    }
+};
+
+class XORGate : public BinaryGate {
+public:
+    void updateState(Pin* updatedPin) {
+        outputPins[0].update(inputPins[0].cachedState != inputPins[1].cachedState);
+    }
+
+    GateType getGateType() {
+        return GateType::XOR;
+    }
+};
+
+class NOTGate : public Gate {
+private:
+    Pin inputPins[1];
+    Pin outputPins[1];
+
+public:
+    NOTGate() {
+        outputPins[0].pinType = PinType::Output;
+
+        inputPins[0].parentGate = this;
+        outputPins[0].parentGate = this;
+        outputPins[0].update(true);
+    }
+
+    void updateState(Pin* updatedPin) {
+        outputPins[0].update(!inputPins[0].cachedState);
+    }
+
+    GateType getGateType() {
+        return GateType::NOT;
+    }
+
+    int getInputPinCount() {
+        return 1;
+    }
+
+    int getOutputPinCount() {
+        return 1;
+    }
+
+    Pin* getInputPins() {
+        return inputPins;
+    }
+
+    Pin* getOutputPins() {
+        return outputPins;
+    }
+};
+
+class Switch : public Gate {
+private:
+    Pin outputPins[1];
+    bool state = false;
+
+public:
+
+    static Switch* clickedOn;
+
+    Switch() {
+        outputPins[0].pinType = PinType::Output;
+        outputPins[0].parentGate = this;
+    }
+
+    void updateState(Pin* updatedPin) {
+        // ...
+    }
+
+    void toggle() {
+        state = !state;
+
+        outputPins[0].update(state);
+    }
+
+    void setState(bool _state) {
+        if (state != _state) {
+            toggle();
+        }
+    }
+
+    bool getState() {
+        return state;
+    }
+
+    GateType getGateType() {
+        return GateType::SWITCH;
+    }
+
+    int getInputPinCount() {
+        return 0;
+    }
+
+    int getOutputPinCount() {
+        return 1;
+    }
+
+    Pin* getInputPins() {
+        return nullptr;
+    }
+
+    Pin* getOutputPins() {
+        return outputPins;
+    }
+};
+
+class Light : public Gate {
+private:
+    Pin inputPins[1];
+
+public:
+    Light() {
+        inputPins[0].parentGate = this;
+    }
+
+    void updateState(Pin* updatedPin) {
+        // state is read straight from the input pin, see getState()
+    }
+
+    bool getState() {
+        return inputPins[0].cachedState;
+    }
+
+    GateType getGateType() {
+        return GateType::LIGHT;
+    }
+
+    int getInputPinCount() {
+        return 1;
+    }
+
+    int getOutputPinCount() {
+        return 0;
+    }
+
+    Pin* getInputPins() {
+        return inputPins;
+    }
+
+    Pin* getOutputPins() {
+        return nullptr;
+    }
+};
+
+FanoutRange Pin::getFanout() const {
+    if (fanoutList == -1) {
+        return FanoutRange{ nullptr, nullptr };
+    }
+    return FanoutRange{ parentGate->fanout->begin(fanoutList), parentGate->fanout->end(fanoutList) };
+}
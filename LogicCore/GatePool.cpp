@@ -0,0 +1,164 @@
+#include "GatePool.h"
+#include "IntegratedChip.h"
+
+#include <algorithm>
+
+static size_t alignSize(size_t size) {
+    const size_t alignment = alignof(std::max_align_t);
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+GatePool::GatePool(size_t _blockSize) {
+    blockSize = _blockSize;
+    currentBlock = 0;
+    used = 0;
+    generationCount = 0;
+    liveCount = 0;
+}
+
+GatePool::~GatePool() {
+    clear();
+    for (char* block : blocks) {
+        ::operator delete(block);
+    }
+}
+
+void* GatePool::allocate(size_t size) {
+    size = alignSize(size);
+
+    while (currentBlock < blocks.size() && used + size > blockSizes[currentBlock]) {
+        currentBlock++;
+        used = 0;
+    }
+
+    if (currentBlock == blocks.size()) {
+        size_t newSize = std::max(blockSize, size);
+        blocks.push_back((char*)::operator new(newSize));
+        blockSizes.push_back(newSize);
+        used = 0;
+    }
+
+    void* memory = blocks[currentBlock] + used;
+    used += size;
+    return memory;
+}
+
+void GatePool::addSlot(Gate* gate) {
+    uint32_t slot;
+    if (freeSlots.empty()) {
+        slot = (uint32_t)slots.size();
+        slots.push_back(Slot{ nullptr, 0 });
+    }
+    else {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+
+    slots[slot].gate = gate;
+    slots[slot].generation = ++generationCount;
+    gate->poolSlot = (int)slot;
+    gate->fanout = &fanout;
+    liveCount++;
+}
+
+IntegratedChip* GatePool::createChip(ChipDefinition* definition) {
+    size_t pinCount = (size_t)(definition->getInputCount() + definition->getOutputCount());
+
+    char* memory = (char*)allocate(alignSize(sizeof(IntegratedChip)) + pinCount * sizeof(Pin));
+    Pin* pins = (Pin*)(memory + alignSize(sizeof(IntegratedChip)));
+
+    IntegratedChip* chip = new (memory) IntegratedChip(definition, pins);
+    addSlot(chip);
+    return chip;
+}
+
+Gate* GatePool::createOfType(GateType type) {
+    switch (type) {
+        case GateType::OR:
+            return create<ORGate>();
+        case GateType::AND:
+            return create<ANDGate>();
+        case GateType::NOT:
+            return create<NOTGate>();
+        case GateType::XOR:
+            return create<XORGate>();
+        case GateType::SWITCH:
+            return create<Switch>();
+        case GateType::LIGHT:
+            return create<Light>();
+        default:
+            break;
+    }
+
+    return nullptr;
+}
+
+void GatePool::destroy(Gate* gate) {
+    uint32_t slot = (uint32_t)gate->poolSlot;
+
+    gate->~Gate();
+
+    slots[slot].gate = nullptr;
+    slots[slot].generation = 0;
+    freeSlots.push_back(slot);
+    liveCount--;
+}
+
+void GatePool::clear() {
+    for (const Slot& slot : slots) {
+        if (slot.gate != nullptr) {
+            slot.gate->~Gate();
+        }
+    }
+
+    slots.clear();
+    freeSlots.clear();
+    liveCount = 0;
+    fanout.reset();
+
+    currentBlock = 0;
+    used = 0;
+}
+
+GateHandle GatePool::handleOf(Gate* gate) const {
+    if (gate == nullptr || gate->poolSlot < 0 || gate->poolSlot >= (int)slots.size()) {
+        return GateHandle();
+    }
+
+    const Slot& slot = slots[gate->poolSlot];
+    if (slot.gate != gate) {
+        return GateHandle();
+    }
+
+    return GateHandle((uint32_t)gate->poolSlot, slot.generation);
+}
+
+PinHandle GatePool::handleOf(Pin* pin) const {
+    if (pin == nullptr) {
+        return PinHandle();
+    }
+
+    int index = -1;
+    if (!pin->parentGate->getPinIndex(pin, pin->pinType, index)) {
+        return PinHandle();
+    }
+
+    return PinHandle(handleOf(pin->parentGate), pin->pinType, index);
+}
+
+Gate* GatePool::get(GateHandle handle) const {
+    if (handle.generation == 0 || handle.slot >= slots.size() || slots[handle.slot].generation != handle.generation) {
+        return nullptr;
+    }
+
+    return slots[handle.slot].gate;
+}
+
+Pin* GatePool::get(const PinHandle& handle) const {
+    Gate* gate = get(handle.gate);
+    if (gate == nullptr) {
+        return nullptr;
+    }
+
+    return gate->getPinByIndex(handle.pinType, handle.index);
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "ChipDefinition.h"
+#include "Fanout.h"
+#include "Gate.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+#define GATE_POOL_BLOCK_SIZE (256 * 1024)     // bytes, a few thousand gates
+#define GATE_POOL_SMALL_BLOCK_SIZE (16 * 1024) // for the pool of a single chip circuit, most are a few dozen gates
+
+class IntegratedChip;
+
+// Names a gate of a pool without owning it. A handle outlives its gate : once the gate is destroyed
+// or the pool cleared, get returns nullptr instead of whatever now sits at the same place.
+struct GateHandle {
+    uint32_t slot;
+    uint32_t generation; // 0 for the null handle, pools never hand it out
+
+    GateHandle() : slot(0), generation(0) {}
+    GateHandle(uint32_t _slot, uint32_t _generation) : slot(_slot), generation(_generation) {}
+};
+
+// A pin by its gate's handle and its index. A connection is named by the handle of its input pin,
+// an input has at most one.
+struct PinHandle {
+    GateHandle gate;
+    PinType pinType;
+    int index;
+
+    PinHandle() : pinType(PinType::Input), index(-1) {}
+    PinHandle(GateHandle _gate, PinType _pinType, int _index) : gate(_gate), pinType(_pinType), index(_index) {}
+};
+
+// Owns the gates of one circuit (the board, a chip circuit loaded from a save, or the chip circuits of
+// a ChipLibrary).
+//
+// Gates are placed one after the other in large blocks, a chip's pins right behind it, so loading a
+// design costs a few block allocations instead of one or two per gate, and the gates of a circuit
+// sit next to each other in memory. Memory is only given back by clear, which rewinds to the first
+// block, keeping the blocks for the next load : no per-gate free, and nothing to fragment across
+// repeated loads. destroy ends a single gate, its bytes stay unused until clear.
+//
+// The pool also owns the FanoutTable of its gates' output pins, emptied by clear, so the wiring of a
+// board goes with it. A gate may be connected to gates of another pool only if that pool outlives it.
+//
+// clear is not O(1) : it still runs every gate's destructor, since a pin has to be taken out of the
+// fanout list of the pin driving it (which may be in another pool) and a chip frees its state.
+//
+// Every gate also gets a slot in a table, tagged with a generation that never repeats, so handles to
+// gates that are gone are detected.
+class GatePool {
+private:
+    struct Slot {
+        Gate* gate;
+        uint32_t generation;
+    };
+
+    std::vector<char*> blocks;
+    std::vector<size_t> blockSizes;
+    size_t blockSize;
+    size_t currentBlock;
+    size_t used; // bytes of the current block
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    uint32_t generationCount;
+    size_t liveCount;
+
+    FanoutTable fanout;
+
+    void* allocate(size_t size);
+    void addSlot(Gate* gate);
+
+public:
+    GatePool(size_t _blockSize = GATE_POOL_BLOCK_SIZE);
+    ~GatePool();
+
+    GatePool(const GatePool&) = delete;
+    GatePool& operator=(const GatePool&) = delete;
+
+    template <class T>
+    T* create() {
+        T* gate = new (allocate(sizeof(T))) T();
+        addSlot(gate);
+        return gate;
+    }
+
+    IntegratedChip* createChip(ChipDefinition* definition);
+
+    // nullptr for INTEGRATED, use createChip
+    Gate* createOfType(GateType type);
+
+    // Ends gate, which must be of this pool. Its pins are unlinked from the ones they were connected to.
+    void destroy(Gate* gate);
+
+    // Ends every gate, O(gates). Handles given so far all become stale.
+    void clear();
+
+    // Null handle for nullptr or a gate of another pool
+    GateHandle handleOf(Gate* gate) const;
+    PinHandle handleOf(Pin* pin) const;
+
+    // nullptr when the gate is gone
+    Gate* get(GateHandle handle) const;
+    Pin* get(const PinHandle& handle) const;
+
+    size_t size() const {
+        return liveCount;
+    }
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#define FNV_OFFSET 14695981039346656037ull
+#define FNV_PRIME 1099511628211ull
+
+// 64 bit FNV-1a, chained by passing the previous result as hash
+inline uint64_t hashBytes(uint64_t hash, const void* bytes, size_t count) {
+    const unsigned char* p = (const unsigned char*)bytes;
+    for (size_t i = 0; i < count; i++) {
+        hash = (hash ^ p[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+// A second 64 bit hash, unrelated to FNV : what two sources colliding under hashBytes are checked with
+inline uint64_t checkBytes(const void* bytes, size_t count) {
+    const unsigned char* p = (const unsigned char*)bytes;
+    uint64_t hash = count;
+    for (size_t i = 0; i < count; i++) {
+        hash = (hash ^ p[i]) * 0x9e3779b97f4a7c15ull;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
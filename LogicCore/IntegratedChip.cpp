@@ -0,0 +1,89 @@
+#include "IntegratedChip.h"
+
+#include <new>
+
+IntegratedChip::IntegratedChip(ChipDefinition* _definition, std::string _name) : IntegratedChip(_definition) {
+    name = _name;
+}
+
+IntegratedChip::IntegratedChip(ChipDefinition* _definition) : IntegratedChip(_definition, nullptr) {
+}
+
+IntegratedChip::IntegratedChip(ChipDefinition* _definition, Pin* pinStorage) {
+
+    definition = _definition;
+    name = definition->name;
+
+    inputPinCount = definition->getInputCount();
+    outputPinCount = definition->getOutputCount();
+
+    ownsPins = pinStorage == nullptr;
+    if (ownsPins) {
+        inputPins = new Pin[inputPinCount + outputPinCount];
+    }
+    else {
+        inputPins = pinStorage;
+        for (int i = 0; i < inputPinCount + outputPinCount; i++) {
+            new (inputPins + i) Pin();
+        }
+    }
+    outputPins = inputPins + inputPinCount;
+
+    inputBits = 0;
+    if (!definition->hasTruthTable()) {
+        state = definition->getInitialState();
+    }
+
+    for (int i = 0; i < outputPinCount; i++) {
+        outputPins[i].pinType = PinType::Output;
+        if (definition->hasTruthTable()) {
+            outputPins[i].cachedState = (definition->lookup(0) >> i) & 1;
+        }
+        else {
+            outputPins[i].cachedState = definition->getOutput(state.data(), i);
+        }
+    }
+
+    for (int i = 0; i < inputPinCount; i++) {
+        inputPins[i].parentGate = this;
+    }
+    for (int i = 0; i < outputPinCount; i++) {
+        outputPins[i].parentGate = this;
+    }
+}
+
+IntegratedChip::~IntegratedChip() {
+    if (ownsPins) {
+        delete[] inputPins;
+        return;
+    }
+
+    for (int i = 0; i < inputPinCount + outputPinCount; i++) {
+        inputPins[i].~Pin();
+    }
+}
+
+void IntegratedChip::updateState(Pin* updatedPin) {
+    int index = (int)(updatedPin - inputPins);
+
+    if (definition->hasTruthTable()) {
+        if (updatedPin->cachedState) {
+            inputBits |= 1u << index;
+        }
+        else {
+            inputBits &= ~(1u << index);
+        }
+
+        uint32_t outputs = definition->lookup(inputBits);
+        for (int i = 0; i < outputPinCount; i++) {
+            outputPins[i].update((outputs >> i) & 1);
+        }
+        return;
+    }
+
+    definition->setInput(state.data(), index, updatedPin->cachedState);
+
+    for (int i = 0; i < outputPinCount; i++) {
+        outputPins[i].update(definition->getOutput(state.data(), i));
+    }
+}
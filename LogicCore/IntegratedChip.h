@@ -0,0 +1,55 @@
+#pragma once
+
+#include "ChipDefinition.h"
+#include "Gate.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One placed chip. The circuit inside is shared through the ChipDefinition; the instance only
+// carries its external pins and one bit of state per internal net, or just its input bits when the
+// definition has a truth table.
+class IntegratedChip : public Gate {
+private:
+    Pin * inputPins, * outputPins; // one array, outputs after inputs
+    int inputPinCount, outputPinCount;
+    bool ownsPins;
+
+    std::vector<uint64_t> state;
+    uint32_t inputBits;
+
+public:
+    ChipDefinition* definition;
+    std::string name;
+
+    IntegratedChip(ChipDefinition* _definition, std::string _name);
+    IntegratedChip(ChipDefinition* _definition);
+
+    // Builds the pins in pinStorage (room for the definition's inputs then outputs) instead of
+    // allocating them, see GatePool::createChip
+    IntegratedChip(ChipDefinition* _definition, Pin* pinStorage);
+    ~IntegratedChip();
+
+    void updateState(Pin* updatedPin);
+
+    GateType getGateType() {
+        return GateType::INTEGRATED;
+    }
+
+    int getInputPinCount() {
+        return inputPinCount;
+    }
+
+    int getOutputPinCount() {
+        return outputPinCount;
+    }
+
+    Pin* getInputPins() {
+        return inputPins;
+    }
+
+    Pin* getOutputPins() {
+        return outputPins;
+    }
+};
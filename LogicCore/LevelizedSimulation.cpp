@@ -0,0 +1,158 @@
+#include "LevelizedSimulation.h"
+
+#include <stack>
+
+bool levelize(const Netlist& netlist, Levelization& out) {
+    int n = netlist.gateCount();
+
+    enum { Unvisited, Visiting, Done };
+    std::vector<char> marks(n, Unvisited);
+
+    out.levels.assign(n, 0);
+    out.order.clear();
+    out.levelStart.clear();
+    out.feedbackGate = -1;
+
+    int maxLevel = 0;
+
+    // (gate, next input to look at)
+    std::stack<std::pair<int, int>> stack;
+
+    for (int root = 0; root < n; root++) {
+        if (marks[root] != Unvisited) { continue; }
+
+        stack.push(std::make_pair(root, 0));
+        marks[root] = Visiting;
+
+        while (!stack.empty()) {
+            int gate = stack.top().first;
+            int& pin = stack.top().second;
+
+            if (netlist.types[gate] != GateType::SWITCH && pin < NETLIST_MAX_INPUTS) {
+                int driver = netlist.inputNet(gate, pin);
+                pin++;
+
+                if (driver == -1 || marks[driver] == Done) { continue; }
+
+                if (marks[driver] == Visiting) {
+                    out.feedbackGate = driver;
+                    return false;
+                }
+
+                marks[driver] = Visiting;
+                stack.push(std::make_pair(driver, 0));
+                continue;
+            }
+
+            // all drivers are done, so this gate's level is known
+            int level = 0;
+            if (netlist.types[gate] != GateType::SWITCH) {
+                for (int i = 0; i < NETLIST_MAX_INPUTS; i++) {
+                    int driver = netlist.inputNet(gate, i);
+                    if (driver != -1 && out.levels[driver] + 1 > level) {
+                        level = out.levels[driver] + 1;
+                    }
+                }
+                if (level == 0) {
+                    level = 1; // gates with nothing connected still get evaluated after the inputs
+                }
+            }
+
+            out.levels[gate] = level;
+            if (level > maxLevel) {
+                maxLevel = level;
+            }
+
+            marks[gate] = Done;
+            stack.pop();
+        }
+    }
+
+    // bucket the gates by level
+    out.levelStart.assign(maxLevel + 2, 0);
+    for (int g = 0; g < n; g++) {
+        if (netlist.types[g] != GateType::SWITCH) {
+            out.levelStart[out.levels[g] + 1]++;
+        }
+    }
+    for (int l = 0; l <= maxLevel; l++) {
+        out.levelStart[l + 1] += out.levelStart[l];
+    }
+
+    out.order.assign(out.levelStart[maxLevel + 1], 0);
+    std::vector<int> fill(out.levelStart.begin(), out.levelStart.end() - 1);
+    for (int g = 0; g < n; g++) {
+        if (netlist.types[g] != GateType::SWITCH) {
+            out.order[fill[out.levels[g]]++] = g;
+        }
+    }
+
+    return true;
+}
+
+void buildLevelizedOps(const Netlist& netlist, const Levelization& levelization, int zeroNet, std::vector<LevelizedOp>& ops) {
+    ops.clear();
+    ops.reserve(levelization.order.size());
+
+    for (int g : levelization.order) {
+        LevelizedOp op;
+        op.type = netlist.types[g];
+        op.a = netlist.inputNet(g, 0);
+        op.b = netlist.inputNet(g, 1);
+        op.out = g;
+
+        if (op.a == -1) { op.a = zeroNet; }
+        if (op.b == -1) { op.b = zeroNet; }
+
+        ops.push_back(op);
+    }
+}
+
+LevelizedSimulation::LevelizedSimulation(const Netlist& netlist) {
+    int n = netlist.gateCount();
+    int zero = n;
+
+    netStates.assign(n + 1, 0);
+    inputs = netlist.primaryInputs;
+    outputs = netlist.primaryOutputs;
+
+    if (!levelize(netlist, levelization)) {
+        return;
+    }
+
+    buildLevelizedOps(netlist, levelization, zero, ops);
+
+    evaluate();
+}
+
+void evaluateLevelizedOps(const LevelizedOp* begin, const LevelizedOp* end, uint8_t* nets) {
+    for (const LevelizedOp* op = begin; op != end; op++) {
+        uint8_t a = nets[op->a];
+        uint8_t b = nets[op->b];
+        uint8_t v;
+
+        switch (op->type) {
+            case GateType::OR:
+                v = a | b;
+                break;
+            case GateType::AND:
+                v = a & b;
+                break;
+            case GateType::XOR:
+                v = a ^ b;
+                break;
+            case GateType::NOT:
+                v = a ^ 1;
+                break;
+            default: // LIGHT
+                v = a;
+                break;
+        }
+
+        nets[op->out] = v;
+    }
+}
+
+void LevelizedSimulation::evaluate() {
+    evaluateLevelizedOps(ops.data(), ops.data() + ops.size(), netStates.data());
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Netlist.h"
+
+#include <cstdint>
+#include <vector>
+
+// Gates of a Netlist sorted so that every gate comes after the gates driving it.
+// Level 0 is the switches (and unconnected inputs), level n gates only read nets of lower levels.
+struct Levelization {
+    std::vector<int> levels;      // level of every gate
+    std::vector<int> order;       // non-switch gates, by increasing level
+    std::vector<int> levelStart;  // order[levelStart[l] .. levelStart[l + 1]) are the gates of level l
+    int feedbackGate;             // a gate on a combinational loop, or -1
+
+    bool isCombinational() const {
+        return feedbackGate == -1;
+    }
+
+    int levelCount() const {
+        return (int)levelStart.size() - 1;
+    }
+};
+
+// Depth-first walk from every gate towards its drivers, at gate granularity.
+// Returns false (and sets feedbackGate) when the netlist contains a loop, e.g. a latch.
+bool levelize(const Netlist& netlist, Levelization& out);
+
+struct LevelizedOp {
+    GateType type;
+    int a, b;   // input nets, unconnected inputs point at the constant zero net
+    int out;
+};
+
+// Flattens the level order into ops. Unconnected inputs read net `zeroNet`, which must always hold 0.
+void buildLevelizedOps(const Netlist& netlist, const Levelization& levelization, int zeroNet, std::vector<LevelizedOp>& ops);
+
+// Evaluates ops [begin, end) in order. The shared kernel of the levelized engines.
+void evaluateLevelizedOps(const LevelizedOp* begin, const LevelizedOp* end, uint8_t* nets);
+
+// Compiled-code evaluation of a purely combinational netlist : one straight pass over the gates
+// in level order computes every net, with no event queue and no glitches.
+class LevelizedSimulation {
+private:
+    std::vector<LevelizedOp> ops;
+    std::vector<int> inputs;
+    std::vector<int> outputs;
+
+public:
+    std::vector<uint8_t> netStates; // one extra net at the end, always 0
+
+    Levelization levelization;
+
+    LevelizedSimulation(const Netlist& netlist);
+
+    bool isValid() {
+        return levelization.isCombinational();
+    }
+
+    void setInput(int index, bool state) {
+        netStates[inputs[index]] = state;
+    }
+
+    bool getOutput(int index) {
+        return netStates[outputs[index]] != 0;
+    }
+
+    void evaluate();
+
+    int opCount() {
+        return (int)ops.size();
+    }
+};
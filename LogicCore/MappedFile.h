@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// A whole file mapped read-only into memory (mmap, MapViewOfFile on Windows).
+// Pages are read from disk when first touched, so opening costs the same whatever the file size.
+class MappedFile {
+private:
+    const char* data;
+    size_t size;
+
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& fileName);
+    void close();
+
+    bool isOpen() const {
+        return data != nullptr;
+    }
+
+    const char* getData() const {
+        return data;
+    }
+
+    size_t getSize() const {
+        return size;
+    }
+};
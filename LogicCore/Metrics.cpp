@@ -0,0 +1,80 @@
+#include "Metrics.h"
+
+#include <algorithm>
+#include <chrono>
+
+StepMetrics Metrics::current;
+StepMetrics Metrics::last;
+StepMetrics Metrics::total;
+unsigned long long Metrics::steps = 0;
+
+static std::chrono::steady_clock::time_point stepStart;
+
+static std::ofstream dumpFile;
+static int dumpInterval = 1;
+static int dumpedSteps = 0; // steps summed into dumpWindow so far
+static StepMetrics dumpWindow;
+
+static void accumulate(StepMetrics& into, const StepMetrics& step) {
+    into.events += step.events;
+    into.gateEvaluations += step.gateEvaluations;
+    into.maxQueueDepth = std::max(into.maxQueueDepth, step.maxQueueDepth);
+    into.stepMs += step.stepMs;
+}
+
+static void writeDumpRow() {
+    dumpFile << Metrics::steps << ',' << dumpWindow.events << ',' << dumpWindow.gateEvaluations << ','
+             << dumpWindow.maxQueueDepth << ',' << dumpWindow.stepMs << '\n';
+
+    dumpWindow = StepMetrics();
+    dumpedSteps = 0;
+}
+
+void Metrics::beginStep() {
+    current = StepMetrics();
+    stepStart = std::chrono::steady_clock::now();
+}
+
+void Metrics::endStep() {
+    current.stepMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - stepStart).count();
+
+    last = current;
+    accumulate(total, current);
+    steps++;
+
+    if (!dumpFile.is_open()) { return; }
+
+    accumulate(dumpWindow, current);
+    dumpedSteps++;
+
+    if (dumpedSteps < dumpInterval) { return; }
+
+    writeDumpRow();
+}
+
+bool Metrics::startDump(const std::string& fileName, int interval) {
+    stopDump();
+
+    dumpFile.open(fileName, std::ofstream::out);
+    if (!dumpFile) { return false; }
+
+    dumpInterval = std::max(interval, 1);
+    dumpedSteps = 0;
+    dumpWindow = StepMetrics();
+
+    dumpFile << "step,events,gate_evaluations,max_queue_depth,ms" << '\n';
+    return true;
+}
+
+void Metrics::stopDump() {
+    if (dumpFile.is_open()) {
+        if (dumpedSteps > 0) {
+            writeDumpRow(); // the unfinished interval
+        }
+        dumpFile.close();
+    }
+}
+
+bool Metrics::isDumping() {
+    return dumpFile.is_open();
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+
+// What the object simulation did during one step (one frame in the GUI, one vector in lgs-sim).
+struct StepMetrics {
+    unsigned long long events = 0;          // queued pin updates processed
+    unsigned long long gateEvaluations = 0; // Gate::updateState calls
+    size_t maxQueueDepth = 0;
+    double stepMs = 0.0;                    // wall time between beginStep and endStep
+};
+
+// Counters for the event loop in Simulation. The count* / sample* hooks are a single add or compare;
+// defining LGS_NO_METRICS turns them into empty functions.
+class Metrics {
+private:
+    Metrics();
+
+public:
+    static StepMetrics current; // being collected
+    static StepMetrics last;    // the last finished step, for the stats overlay
+    static StepMetrics total;   // every step since start, maxQueueDepth is the overall maximum
+    static unsigned long long steps;
+
+    static void countEvents(int count) {
+#ifndef LGS_NO_METRICS
+        current.events += count;
+#endif
+    }
+
+    static void countEvaluation() {
+#ifndef LGS_NO_METRICS
+        current.gateEvaluations++;
+#endif
+    }
+
+    static void sampleQueueDepth(size_t depth) {
+#ifndef LGS_NO_METRICS
+        if (depth > current.maxQueueDepth) {
+            current.maxQueueDepth = depth;
+        }
+#endif
+    }
+
+    static void beginStep();
+    static void endStep();
+
+    // Appends a CSV row to fileName every `interval` steps, summed over those steps. Returns false if
+    // the file cannot be opened.
+    static bool startDump(const std::string& fileName, int interval);
+    static void stopDump();
+    static bool isDumping();
+};
@@ -0,0 +1,255 @@
+#include "NativeSimulation.h"
+#include "Hash.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <intrin.h>
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#include <sys/utsname.h>
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(_WIN32)
+#include <cpuid.h>
+#endif
+
+std::string nativeTarget() {
+    char text[160];
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    unsigned int vendor[4] = { 0 }, features[4] = { 0 }, extended[4] = { 0 };
+#ifdef _WIN32
+    __cpuid((int*)vendor, 0);
+    __cpuid((int*)features, 1);
+    if (vendor[0] >= 7) {
+        __cpuidex((int*)extended, 7, 0);
+    }
+#else
+    __get_cpuid(0, &vendor[0], &vendor[1], &vendor[2], &vendor[3]);
+    __get_cpuid(1, &features[0], &features[1], &features[2], &features[3]);
+    if (vendor[0] >= 7) {
+        __get_cpuid_count(7, 0, &extended[0], &extended[1], &extended[2], &extended[3]);
+    }
+#endif
+    char name[13];
+    std::memcpy(name, &vendor[1], 4);
+    std::memcpy(name + 4, &vendor[3], 4);
+    std::memcpy(name + 8, &vendor[2], 4);
+    name[12] = '\0';
+
+    // the signature gives the model, ecx / edx of leaf 1 and ebx / ecx / edx of leaf 7 the instruction sets
+    std::snprintf(text, sizeof(text), "x86 %s %08x %08x %08x %08x %08x %08x", name,
+                  features[0], features[2], features[3], extended[1], extended[2], extended[3]);
+#elif defined(_WIN32)
+    std::snprintf(text, sizeof(text), "windows");
+#else
+    struct utsname machine;
+    if (uname(&machine) != 0) {
+        return "unknown";
+    }
+    std::snprintf(text, sizeof(text), "%s %s", machine.sysname, machine.machine);
+#endif
+
+    return text;
+}
+
+std::string nativeCacheEntry(const std::string& compiler, const std::string& source) {
+    return "// compiler : " + compiler + " " NATIVE_COMPILER_FLAGS "\n"
+           "// target : " + nativeTarget() + "\n" + source;
+}
+
+uint64_t nativeKernelKey(const std::string& entry) {
+    return hashBytes(FNV_OFFSET, entry.data(), entry.size());
+}
+
+void writeNativeSource(const Netlist& netlist, const Levelization& levelization, std::ostream& out) {
+    static const char* functions[] = { "OR", "AND", "NOT", "XOR" };
+
+    int n = netlist.gateCount();
+    std::vector<LevelizedOp> ops;
+    buildLevelizedOps(netlist, levelization, n, ops);
+
+    out << "// " << n << " gate netlist, written by writeNativeSource\n";
+    out << "#include <stdint.h>\n\n";
+    out << "#define W " << NATIVE_WORDS << "\n\n";
+    out << "#if defined(__GNUC__) || defined(__clang__)\n";
+    out << "#define EXPORT __attribute__((visibility(\"default\")))\n";
+    out << "typedef uint64_t net __attribute__((vector_size(W * 8), aligned(8)));\n";
+    out << "#define OR(a, b) ((a) | (b))\n#define AND(a, b) ((a) & (b))\n#define XOR(a, b) ((a) ^ (b))\n#define NOT(a, b) (~(a))\n";
+    out << "#else\n";
+    out << "#define EXPORT __declspec(dllexport)\n";
+    out << "struct net { uint64_t w[W]; };\n";
+    out << "static inline net OR(net a, net b) { net o; for (int i = 0; i < W; i++) { o.w[i] = a.w[i] | b.w[i]; } return o; }\n";
+    out << "static inline net AND(net a, net b) { net o; for (int i = 0; i < W; i++) { o.w[i] = a.w[i] & b.w[i]; } return o; }\n";
+    out << "static inline net XOR(net a, net b) { net o; for (int i = 0; i < W; i++) { o.w[i] = a.w[i] ^ b.w[i]; } return o; }\n";
+    out << "static inline net NOT(net a, net b) { net o; for (int i = 0; i < W; i++) { o.w[i] = ~a.w[i]; } return o; }\n";
+    out << "#endif\n\n";
+    out << "extern \"C\" EXPORT void " << NATIVE_KERNEL_SYMBOL << "(uint64_t* nets) {\n";
+    out << "    net* n = (net*)nets;\n";
+
+    // every net is a local, the compiler keeps them in vector registers or spills them as it sees fit;
+    // only the nets nothing computes (switches, the zero net) are read and only the outputs written
+    std::vector<char> computed(n + 1, 0);
+    for (const LevelizedOp& op : ops) {
+        computed[op.out] = 1;
+    }
+    std::vector<char> loaded(n + 1, 0);
+    for (const LevelizedOp& op : ops) {
+        for (int net : { op.a, op.b }) {
+            if (!computed[net] && !loaded[net]) {
+                loaded[net] = 1;
+                out << "    net v" << net << " = n[" << net << "];\n";
+            }
+        }
+    }
+
+    for (const LevelizedOp& op : ops) {
+        out << "    net v" << op.out << " = ";
+        if (op.type == GateType::LIGHT) {
+            out << "v" << op.a << ";\n";
+        }
+        else {
+            out << functions[(int)op.type] << "(v" << op.a << ", v" << op.b << ");\n";
+        }
+    }
+
+    for (int net : netlist.primaryOutputs) {
+        out << "    n[" << net << "] = v" << net << ";\n";
+    }
+
+    out << "}\n";
+}
+
+static void makeDirectory(const std::string& directory) {
+#ifdef _WIN32
+    _mkdir(directory.c_str());
+#else
+    mkdir(directory.c_str(), 0755);
+#endif
+}
+
+static bool fileExists(const std::string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0;
+}
+
+static bool fileHolds(const std::string& path, const std::string& text) {
+    std::ifstream ifs(path, std::ifstream::in | std::ifstream::binary);
+    if (!ifs) { return false; }
+
+    std::ostringstream content;
+    content << ifs.rdbuf();
+    return content.str() == text;
+}
+
+static std::string compilerName() {
+    const char* compiler = std::getenv("LGS_CXX");
+    if (compiler == nullptr || compiler[0] == '\0') {
+        compiler = NATIVE_COMPILER;
+    }
+    return compiler;
+}
+
+NativeSimulation::NativeSimulation(const Netlist& netlist, const std::string& cacheDirectory) {
+    library = nullptr;
+    kernel = nullptr;
+
+    int n = netlist.gateCount();
+    netStates.assign((size_t)(n + 1) * NATIVE_WORDS, 0);
+    inputs = netlist.primaryInputs;
+    outputs = netlist.primaryOutputs;
+
+    if (!levelize(netlist, levelization)) {
+        error = "the netlist has a feedback loop";
+        return;
+    }
+
+    std::string compiler = compilerName();
+    std::ostringstream source;
+    writeNativeSource(netlist, levelization, source);
+    std::string entry = nativeCacheEntry(compiler, source.str());
+
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", (unsigned long long)nativeKernelKey(entry));
+    std::string base = cacheDirectory + "/" + name;
+    std::string sourcePath = base + ".cpp";
+    std::string libraryPath = base + NATIVE_LIBRARY_EXTENSION;
+
+    // a library whose source differs is another kernel with the same key, it is replaced
+    if (!fileExists(libraryPath) || !fileHolds(sourcePath, entry)) {
+        makeDirectory(cacheDirectory);
+
+        std::ofstream ofs(sourcePath, std::ofstream::out | std::ofstream::binary);
+        ofs << entry;
+        ofs.close();
+        if (!ofs) {
+            error = "cannot write " + sourcePath;
+            return;
+        }
+
+        if (!build(compiler, sourcePath, libraryPath)) {
+            return;
+        }
+    }
+
+#ifdef _WIN32
+    library = LoadLibraryA(libraryPath.c_str());
+    if (library != nullptr) {
+        kernel = (void (*)(uint64_t*))GetProcAddress((HMODULE)library, NATIVE_KERNEL_SYMBOL);
+    }
+#else
+    library = dlopen(libraryPath.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (library != nullptr) {
+        kernel = (void (*)(uint64_t*))dlsym(library, NATIVE_KERNEL_SYMBOL);
+    }
+#endif
+
+    if (kernel == nullptr) {
+        error = "cannot load " + libraryPath;
+    }
+}
+
+NativeSimulation::~NativeSimulation() {
+    if (library == nullptr) { return; }
+
+#ifdef _WIN32
+    FreeLibrary((HMODULE)library);
+#else
+    dlclose(library);
+#endif
+}
+
+// Builds to a temporary name and renames it into place, so a library that exists is complete
+bool NativeSimulation::build(const std::string& compiler, const std::string& source, const std::string& libraryPath) {
+    std::string temporary = libraryPath + ".tmp" + NATIVE_LIBRARY_EXTENSION;
+
+#ifdef _WIN32
+    std::string command = compiler + " " NATIVE_COMPILER_FLAGS " \"" + source + "\" /Fo\"" + source + ".obj\" /Fe\"" + temporary + "\" > nul";
+#else
+    std::string command = compiler + " " NATIVE_COMPILER_FLAGS " -o \"" + temporary + "\" \"" + source + "\"";
+#endif
+
+    if (std::system(command.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        error = "compiling " + source + " failed : " + command;
+        return false;
+    }
+
+    std::remove(libraryPath.c_str());
+    if (std::rename(temporary.c_str(), libraryPath.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        error = "cannot write " + libraryPath;
+        return false;
+    }
+
+    return true;
+}
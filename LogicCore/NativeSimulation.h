@@ -0,0 +1,92 @@
+#pragma once
+
+#include "LevelizedSimulation.h"
+#include "Netlist.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#define NATIVE_WORDS 8 // 64 bit words per net, 512 patterns per evaluate like PatternSimulation512
+#define NATIVE_KERNEL_SYMBOL "lgs_evaluate"
+#define NATIVE_CACHE_DIRECTORY "native-cache"
+
+#ifdef _WIN32
+#define NATIVE_COMPILER "cl"
+#define NATIVE_COMPILER_FLAGS "/nologo /O2 /LD"
+#define NATIVE_LIBRARY_EXTENSION ".dll"
+#else
+#define NATIVE_COMPILER "c++"
+#define NATIVE_COMPILER_FLAGS "-O1 -march=native -shared -fPIC"
+#define NATIVE_LIBRARY_EXTENSION ".so"
+#endif
+
+// The processor the kernels are built for (-march=native) : vendor, model and feature bits on x86,
+// the machine name elsewhere
+std::string nativeTarget();
+
+// What a cache entry is built from : the compiler command without its file names, the target and the
+// source, one comment line each ahead of the source. It is written as the entry's .cpp file, and a
+// cached library is only used when that file still holds exactly the same text.
+std::string nativeCacheEntry(const std::string& compiler, const std::string& source);
+
+// Key of a cache entry, a hash of all of it
+uint64_t nativeKernelKey(const std::string& entry);
+
+// C++ source of the kernel : extern "C" void lgs_evaluate(uint64_t* nets), one local variable of
+// NATIVE_WORDS words per gate, computed in level order, on the same net layout as PatternSimulation<NATIVE_WORDS>.
+void writeNativeSource(const Netlist& netlist, const Levelization& levelization, std::ostream& out);
+
+// PatternSimulation with the gates compiled to machine code instead of interpreted : the netlist is
+// written out as C++, built into a shared library by the installed compiler (the LGS_CXX environment
+// variable, NATIVE_COMPILER by default) and loaded with dlopen / LoadLibrary.
+//
+// Libraries are kept in the cache directory under their nativeKernelKey, so a design is only compiled
+// the first time it is run with a given compiler on a given processor. On a hit the entry's .cpp file
+// is compared with the expected text, so neither a hash collision nor a cache copied from another
+// machine loads the wrong code. Compiling takes seconds for thousands of gates and grows with the
+// netlist, this is for regression runs over a fixed design, not for a circuit being edited. -O1 : -O2
+// takes longer and generates the same straight-line code.
+class NativeSimulation {
+private:
+    std::vector<int> inputs;
+    std::vector<int> outputs;
+
+    void* library;
+    void (*kernel)(uint64_t* nets);
+
+    bool build(const std::string& compiler, const std::string& source, const std::string& libraryPath);
+
+public:
+    static const int Patterns = NATIVE_WORDS * 64;
+
+    std::vector<uint64_t> netStates; // NATIVE_WORDS per net, one extra constant zero net at the end; only
+                                     // the inputs and outputs are written back
+    Levelization levelization;
+    std::string error; // why isValid is false
+
+    NativeSimulation(const Netlist& netlist, const std::string& cacheDirectory = NATIVE_CACHE_DIRECTORY);
+    ~NativeSimulation();
+
+    NativeSimulation(const NativeSimulation&) = delete;
+    NativeSimulation& operator=(const NativeSimulation&) = delete;
+
+    // False for a netlist with feedback loops, or when the kernel could not be compiled or loaded
+    bool isValid() {
+        return kernel != nullptr;
+    }
+
+    // Bits of input `index` for patterns word * 64 .. word * 64 + 63
+    void setInput(int index, int word, uint64_t bits) {
+        netStates[(size_t)inputs[index] * NATIVE_WORDS + word] = bits;
+    }
+
+    uint64_t getOutput(int index, int word) {
+        return netStates[(size_t)outputs[index] * NATIVE_WORDS + word];
+    }
+
+    void evaluate() {
+        kernel(netStates.data());
+    }
+};
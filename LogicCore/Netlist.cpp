@@ -0,0 +1,304 @@
+#include "Netlist.h"
+#include "IntegratedChip.h"
+#include "Serialization.h"
+#include "WaveformRecorder.h"
+
+#include <map>
+#include <unordered_map>
+
+namespace {
+
+// Switches and lights of a circuit, in circuit order. They are the boundary of a chip built from it.
+// Built once per definition, however many times it is instantiated.
+struct CircuitInfo {
+    std::vector<Switch*> switches;
+    std::vector<Light*> lights;
+
+    std::unordered_map<Gate*, int> positions; // gate -> its index in the circuit
+    std::vector<int> switchIndex;             // by position, the index among switches (-1 for other gates)
+};
+
+// One instance of a circuit in the hierarchy. The top level scope has no chip.
+struct Scope {
+    Scope* parent;
+    IntegratedChip* chip;
+    CircuitPtr circuit;
+    const CircuitInfo* info;
+    std::vector<int> gateIndex;     // by position, -1 for gates that are not in the netlist
+    std::vector<Scope*> children;   // by position, the scope of each integrated chip
+};
+
+class NetlistCompiler {
+private:
+    Netlist& netlist;
+    std::map<CircuitPtr, CircuitInfo> infos;
+    std::vector<Scope*> scopes;
+
+    Scope* instantiate(CircuitPtr circuit, Scope* parent, IntegratedChip* chip) {
+        Scope* scope = new Scope();
+        scope->parent = parent;
+        scope->chip = chip;
+        scope->circuit = circuit;
+        scope->info = &infos[circuit];
+        scope->gateIndex.assign(circuit->size(), -1);
+        scope->children.assign(circuit->size(), nullptr);
+        scopes.push_back(scope);
+
+        for (size_t position = 0; position < circuit->size(); position++) {
+            Gate* gate = (*circuit)[position];
+            GateType type = gate->getGateType();
+
+            if (type == GateType::INTEGRATED) {
+                IntegratedChip* ic = static_cast<IntegratedChip*>(gate);
+                scope->children[position] = instantiate(ic->definition->getCircuit(), scope, ic);
+                continue;
+            }
+
+            // a chip's switches and lights are only its boundary
+            if (chip != nullptr && (type == GateType::SWITCH || type == GateType::LIGHT)) {
+                continue;
+            }
+
+            int index = netlist.gateCount();
+            scope->gateIndex[position] = index;
+            netlist.types.push_back(type);
+            netlist.origins.push_back(gate);
+            for (int i = 0; i < NETLIST_MAX_INPUTS; i++) {
+                netlist.inputNets.push_back(-1);
+            }
+
+            if (chip == nullptr && type == GateType::SWITCH) {
+                netlist.primaryInputs.push_back(index);
+            }
+            if (chip == nullptr && type == GateType::LIGHT) {
+                netlist.primaryOutputs.push_back(index);
+            }
+        }
+
+        return scope;
+    }
+
+    typedef std::pair<Pin*, Scope*> WalkState;
+
+    // One hop of walkNet from an output pin, see resolveNet
+    static bool crossBoundary(WalkState& state) {
+        Pin* output = state.first;
+        Scope* scope = state.second;
+        if (output == nullptr) { return false; }
+
+        auto found = scope->info->positions.find(output->parentGate);
+        if (found == scope->info->positions.end()) { return false; }
+        int position = found->second;
+        Gate* gate = output->parentGate;
+
+        if (gate->getGateType() == GateType::INTEGRATED) {
+            // chip output : continue from the light that feeds it, inside the chip
+            Scope* inner = scope->children[position];
+            int index = (int)(output - gate->getOutputPins());
+            state = WalkState(inner->info->lights[index]->getInputPins()->connectedTo, inner);
+            return true;
+        }
+
+        int switchIndex = scope->info->switchIndex[position];
+        if (switchIndex != -1 && scope->chip != nullptr) {
+            // chip input : continue from whatever drives the chip pin, outside the chip
+            state = WalkState(scope->chip->getInputPins()[switchIndex].connectedTo, scope->parent);
+            return true;
+        }
+
+        return false;
+    }
+
+    // Net driven by an output pin, following it through chip boundaries. -1 when nothing drives it.
+    int resolveNet(Pin* output, Scope* scope) {
+        WalkState state(output, scope);
+        if (!walkNet(state, crossBoundary) || state.first == nullptr) { return -1; }
+
+        auto found = state.second->info->positions.find(state.first->parentGate);
+        if (found == state.second->info->positions.end()) { return -1; } // driven from outside the circuit
+        return state.second->gateIndex[found->second];
+    }
+
+    void connect(Scope* scope) {
+        for (size_t position = 0; position < scope->circuit->size(); position++) {
+            Gate* gate = (*scope->circuit)[position];
+            int index = scope->gateIndex[position];
+            if (index == -1) { continue; }
+
+            int c = gate->getInputPinCount();
+            Pin* pins = gate->getInputPins();
+            for (int i = 0; i < c && i < NETLIST_MAX_INPUTS; i++) {
+                netlist.inputNets[index * NETLIST_MAX_INPUTS + i] = resolveNet(pins[i].connectedTo, scope);
+            }
+        }
+    }
+
+public:
+    NetlistCompiler(Netlist& _netlist) : netlist(_netlist) {}
+
+    ~NetlistCompiler() {
+        for (auto scope : scopes) {
+            delete scope;
+        }
+    }
+
+    void compile(CircuitPtr circuit) {
+        // children come before their parents, so every chip definition is described once
+        std::vector<CircuitPtr> list = topoSort(circuit);
+        for (CircuitPtr c : list) {
+            CircuitInfo& info = infos[c];
+            info.switchIndex.assign(c->size(), -1);
+            for (size_t position = 0; position < c->size(); position++) {
+                Gate* gate = (*c)[position];
+                info.positions[gate] = (int)position;
+
+                if (gate->getGateType() == GateType::SWITCH) {
+                    info.switchIndex[position] = (int)info.switches.size();
+                    info.switches.push_back(static_cast<Switch*>(gate));
+                }
+                else if (gate->getGateType() == GateType::LIGHT) {
+                    info.lights.push_back(static_cast<Light*>(gate));
+                }
+            }
+        }
+
+        instantiate(circuit, nullptr, nullptr);
+
+        for (auto scope : scopes) {
+            connect(scope);
+        }
+
+        buildFanout(netlist);
+    }
+};
+
+}
+
+void buildFanout(Netlist& netlist) {
+    int n = netlist.gateCount();
+
+    netlist.fanoutStart.assign(n + 1, 0);
+    for (int g = 0; g < n; g++) {
+        for (int i = 0; i < NETLIST_MAX_INPUTS; i++) {
+            int net = netlist.inputNet(g, i);
+            if (net != -1 && !(i == 1 && netlist.inputNet(g, 0) == net)) {
+                netlist.fanoutStart[net + 1]++;
+            }
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        netlist.fanoutStart[i + 1] += netlist.fanoutStart[i];
+    }
+
+    netlist.fanout.assign(netlist.fanoutStart[n], 0);
+    std::vector<int> fill(netlist.fanoutStart.begin(), netlist.fanoutStart.end() - 1);
+    for (int g = 0; g < n; g++) {
+        for (int i = 0; i < NETLIST_MAX_INPUTS; i++) {
+            int net = netlist.inputNet(g, i);
+            if (net != -1 && !(i == 1 && netlist.inputNet(g, 0) == net)) {
+                netlist.fanout[fill[net]++] = g;
+            }
+        }
+    }
+}
+
+Netlist compileNetlist(std::vector<Gate*>& circuit) {
+    Netlist netlist;
+
+    NetlistCompiler compiler(netlist);
+    compiler.compile(&circuit);
+
+    return netlist;
+}
+
+NetlistSimulation::NetlistSimulation(const Netlist& _netlist) : netlist(_netlist) {
+    gateEvaluations = 0;
+    cycles = 0;
+    recorder = nullptr;
+
+    int n = netlist.gateCount();
+
+    netStates.assign(n, 0);
+    queued.assign(n, 1);
+
+    // evaluate everything once, so NOT gates start high like their object counterparts
+    for (int g = 0; g < n; g++) {
+        pending.push_back(g);
+    }
+}
+
+void NetlistSimulation::queueFanout(int net) {
+    for (int i = netlist.fanoutStart[net]; i < netlist.fanoutStart[net + 1]; i++) {
+        int g = netlist.fanout[i];
+        if (!queued[g]) {
+            queued[g] = 1;
+            pending.push_back(g);
+        }
+    }
+}
+
+void NetlistSimulation::setInput(int index, bool state) {
+    int g = netlist.primaryInputs[index];
+    if (netStates[g] == (char)state) { return; }
+
+    netStates[g] = state;
+    queueFanout(g);
+
+    if (recorder != nullptr && netSignals[g] != -1) {
+        recorder->change(cycles, netSignals[g], state);
+    }
+}
+
+bool NetlistSimulation::getOutput(int index) {
+    return netStates[netlist.primaryOutputs[index]] != 0;
+}
+
+bool NetlistSimulation::settle(int maxCycles) {
+    std::vector<int> wave;
+    std::vector<int> changed;
+
+    for (int cycle = 0; !pending.empty(); cycle++) {
+        if (cycle >= maxCycles) {
+            return false;
+        }
+
+        wave.swap(pending);
+        pending.clear();
+        changed.clear();
+        cycles++;
+
+        for (int g : wave) {
+            queued[g] = 0;
+
+            GateType type = netlist.types[g];
+            if (type == GateType::SWITCH) { continue; }
+
+            int a = netlist.inputNet(g, 0);
+            int b = netlist.inputNet(g, 1);
+            bool va = a != -1 && netStates[a];
+            bool vb = b != -1 && netStates[b];
+
+            bool value = type == GateType::LIGHT ? va : evaluateGate(type, va, vb);
+            gateEvaluations++;
+            if (value != (netStates[g] != 0)) {
+                changed.push_back(g);
+            }
+        }
+
+        for (int g : changed) {
+            netStates[g] = !netStates[g];
+            queueFanout(g);
+
+            if (recorder != nullptr && netSignals[g] != -1) {
+                recorder->change(cycles, netSignals[g], netStates[g] != 0);
+            }
+        }
+    }
+
+    return true;
+}
+
+void NetlistSimulation::record(WaveformRecorder* _recorder, const std::vector<int>& _netSignals) {
+    recorder = _recorder;
+    netSignals = _netSignals;
+}
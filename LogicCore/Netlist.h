@@ -0,0 +1,109 @@
+#pragma once
+
+#include "Gate.h"
+
+#include <cstdint>
+#include <set>
+#include <vector>
+
+#define NETLIST_MAX_INPUTS 2
+#define NETLIST_WALK_CHECK_HOPS 64 // boundary hops walkNet makes before it starts looking for a cycle
+
+class WaveformRecorder;
+
+// Flattened, index based form of a circuit. Integrated chips are inlined down to primitive gates
+// and their boundary switches/lights disappear, so a gate costs the same no matter how deep it was nested.
+//
+// Every gate drives at most one net, so net i is simply the output of gate i.
+struct Netlist {
+    std::vector<GateType> types;      // OR, AND, NOT, XOR, SWITCH or LIGHT
+    std::vector<int> inputNets;       // NETLIST_MAX_INPUTS per gate, -1 when the input is unconnected (reads 0)
+
+    // CSR fanout : gates reading net i are fanout[fanoutStart[i] .. fanoutStart[i + 1])
+    std::vector<int> fanoutStart;
+    std::vector<int> fanout;
+
+    std::vector<int> primaryInputs;   // top level switches, in circuit order
+    std::vector<int> primaryOutputs;  // top level lights, in circuit order
+
+    std::vector<Gate*> origins;       // the gate object each entry was compiled from (nullptr from a binary file)
+
+    int gateCount() const {
+        return (int)types.size();
+    }
+
+    int inputNet(int gate, int pin) const {
+        return inputNets[gate * NETLIST_MAX_INPUTS + pin];
+    }
+};
+
+inline bool evaluateGate(GateType type, bool a, bool b) {
+    switch (type) {
+        case GateType::OR:
+            return a || b;
+        case GateType::AND:
+            return a && b;
+        case GateType::NOT:
+            return !a;
+        case GateType::XOR:
+            return a != b;
+        default:
+            return false;
+    }
+}
+
+// The walk both netlist compilers use to find what drives a net across chip boundaries. step(state)
+// crosses one boundary (a chip output to the light feeding it inside the chip, a chip input to what
+// drives the chip pin outside) and returns true, or returns false when state is the driving gate or
+// nothing. State must be ordered (operator<).
+//
+// Returns false when the walk only goes round wires through boundaries (a chip made of plain switch to
+// light wiring with an output fed back to its input) : nothing drives such a net. Hops are only
+// remembered past NETLIST_WALK_CHECK_HOPS, far more than any nesting needs.
+template <class State, class Step>
+bool walkNet(State& state, Step step) {
+    std::set<State> seen;
+    for (int hops = 0; step(state); hops++) {
+        if (hops >= NETLIST_WALK_CHECK_HOPS && !seen.insert(state).second) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Netlist compileNetlist(std::vector<Gate*>& circuit);
+
+// Fills fanoutStart / fanout from inputNets
+void buildFanout(Netlist& netlist);
+
+// Zero-delay evaluator over a Netlist. Works in delta cycles like Simulation::processTick :
+// every gate queued in a cycle is evaluated against the same net values, then the changes are applied.
+class NetlistSimulation {
+private:
+    const Netlist& netlist;
+
+    std::vector<int> pending;
+    std::vector<char> queued;
+
+    WaveformRecorder* recorder;
+    std::vector<int> netSignals;
+
+    void queueFanout(int net);
+
+public:
+    std::vector<char> netStates;
+
+    uint64_t gateEvaluations;
+    uint64_t cycles; // delta cycles run so far, the time axis of recorded waveforms
+
+    NetlistSimulation(const Netlist& _netlist);
+
+    void setInput(int index, bool state);
+    bool getOutput(int index);
+
+    // Runs delta cycles until nothing changes. Returns false if maxCycles was hit (oscillation).
+    bool settle(int maxCycles);
+
+    // Sends every change of a net with a signal (see addNetlistSignals) to recorder, null to stop.
+    void record(WaveformRecorder* _recorder, const std::vector<int>& _netSignals);
+};
@@ -0,0 +1,324 @@
+#include "NetlistOptimizer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+
+// While optimizing, the value of a gate is a net of the original netlist or one of these
+#define CONSTANT_0 -1
+#define CONSTANT_1 -3
+#define NO_VALUE -4
+
+// Tarjan's strongly connected components over the input edges, without recursion so deep netlists
+// do not overflow the stack. order receives every gate after the gates driving it (a loop's gates
+// together, in no particular order); cyclic marks the gates on a loop.
+static void findLoops(const Netlist& netlist, std::vector<int>& order, std::vector<char>& cyclic) {
+    int n = netlist.gateCount();
+
+    std::vector<int> index(n, -1);
+    std::vector<int> low(n, 0);
+    std::vector<char> onStack(n, 0);
+    std::vector<int> stack;
+    std::vector<std::pair<int, int>> calls; // gate, next input pin to follow
+    int counter = 0;
+
+    order.clear();
+    order.reserve(n);
+    cyclic.assign(n, 0);
+
+    for (int root = 0; root < n; root++) {
+        if (index[root] != -1) { continue; }
+
+        index[root] = low[root] = counter++;
+        stack.push_back(root);
+        onStack[root] = 1;
+        calls.push_back(std::make_pair(root, 0));
+
+        while (!calls.empty()) {
+            int v = calls.back().first;
+            int pin = calls.back().second;
+
+            if (pin < NETLIST_MAX_INPUTS) {
+                calls.back().second++;
+
+                int w = netlist.inputNet(v, pin);
+                if (w == -1) { continue; }
+                if (w == v) {
+                    cyclic[v] = 1;
+                }
+
+                if (index[w] == -1) {
+                    index[w] = low[w] = counter++;
+                    stack.push_back(w);
+                    onStack[w] = 1;
+                    calls.push_back(std::make_pair(w, 0));
+                }
+                else if (onStack[w]) {
+                    low[v] = std::min(low[v], index[w]);
+                }
+                continue;
+            }
+
+            calls.pop_back();
+            if (!calls.empty()) {
+                int parent = calls.back().first;
+                low[parent] = std::min(low[parent], low[v]);
+            }
+
+            if (low[v] == index[v]) {
+                size_t first = stack.size();
+                do {
+                    first--;
+                } while (stack[first] != v);
+
+                bool loop = stack.size() - first > 1;
+                for (size_t i = first; i < stack.size(); i++) {
+                    onStack[stack[i]] = 0;
+                    order.push_back(stack[i]);
+                    if (loop) {
+                        cyclic[stack[i]] = 1;
+                    }
+                }
+                stack.resize(first);
+            }
+        }
+    }
+}
+
+OptimizedNetlist optimizeNetlist(const Netlist& netlist, unsigned passes) {
+    OptimizedNetlist result;
+    result.foldedGates = 0;
+    result.inversions = 0;
+    result.mergedGates = 0;
+    result.deadGates = 0;
+
+    int n = netlist.gateCount();
+
+    std::vector<int> order;
+    std::vector<char> frozen;
+    findLoops(netlist, order, frozen);
+
+    // loops and everything feeding them stay as they are
+    std::vector<int> work;
+    for (int g = 0; g < n; g++) {
+        if (frozen[g]) {
+            work.push_back(g);
+        }
+    }
+    while (!work.empty()) {
+        int g = work.back();
+        work.pop_back();
+        for (int i = 0; i < NETLIST_MAX_INPUTS; i++) {
+            int net = netlist.inputNet(g, i);
+            if (net != -1 && !frozen[net]) {
+                frozen[net] = 1;
+                work.push_back(net);
+            }
+        }
+    }
+
+    // the gate each original gate became : its type and input values, when value[g] == g
+    std::vector<GateType> types(netlist.types);
+    std::vector<int> inA(n, CONSTANT_0);
+    std::vector<int> inB(n, CONSTANT_0);
+    std::vector<int> value(n, NO_VALUE);
+
+    std::unordered_map<uint64_t, int> common;
+    if (passes & OPTIMIZE_COMMON) {
+        common.reserve(n);
+    }
+
+    auto resolve = [&](int net) {
+        return net == -1 ? CONSTANT_0 : value[net];
+    };
+    auto isConstant = [](int v) {
+        return v == CONSTANT_0 || v == CONSTANT_1;
+    };
+
+    for (int g : order) {
+        GateType type = types[g];
+
+        if (frozen[g] || type == GateType::SWITCH) {
+            value[g] = g;
+            inA[g] = netlist.inputNet(g, 0) == -1 ? CONSTANT_0 : netlist.inputNet(g, 0);
+            inB[g] = netlist.inputNet(g, 1) == -1 ? CONSTANT_0 : netlist.inputNet(g, 1);
+            continue;
+        }
+
+        int a = resolve(netlist.inputNet(g, 0));
+        int b = resolve(netlist.inputNet(g, 1));
+
+        if (type == GateType::LIGHT) {
+            value[g] = g;
+            inA[g] = a;
+            continue;
+        }
+        if (type == GateType::NOT) {
+            b = CONSTANT_0;
+        }
+
+        int folded = NO_VALUE;
+
+        if (passes & OPTIMIZE_CONSTANTS) {
+            switch (type) {
+                case GateType::NOT:
+                    if (isConstant(a)) { folded = a == CONSTANT_0 ? CONSTANT_1 : CONSTANT_0; }
+                    break;
+                case GateType::AND:
+                    if (a == CONSTANT_0 || b == CONSTANT_0) { folded = CONSTANT_0; }
+                    else if (a == CONSTANT_1) { folded = b; }
+                    else if (b == CONSTANT_1) { folded = a; }
+                    break;
+                case GateType::OR:
+                    if (a == CONSTANT_1 || b == CONSTANT_1) { folded = CONSTANT_1; }
+                    else if (a == CONSTANT_0) { folded = b; }
+                    else if (b == CONSTANT_0) { folded = a; }
+                    break;
+                case GateType::XOR:
+                    if (isConstant(a) && isConstant(b)) { folded = a != b ? CONSTANT_1 : CONSTANT_0; }
+                    else if (a == CONSTANT_0) { folded = b; }
+                    else if (b == CONSTANT_0) { folded = a; }
+                    else if (a == CONSTANT_1) { type = GateType::NOT; a = b; b = CONSTANT_0; }
+                    else if (b == CONSTANT_1) { type = GateType::NOT; b = CONSTANT_0; }
+                    break;
+                default:
+                    break;
+            }
+            if (folded != NO_VALUE) {
+                result.foldedGates++;
+            }
+        }
+
+        if (folded == NO_VALUE && (passes & OPTIMIZE_COMMON) && type != GateType::NOT && a == b) {
+            folded = type == GateType::XOR ? CONSTANT_0 : a;
+            result.foldedGates++;
+        }
+
+        if (folded == NO_VALUE && (passes & OPTIMIZE_INVERSIONS) && type == GateType::NOT && a >= 0 && types[a] == GateType::NOT) {
+            folded = inA[a];
+            result.inversions++;
+        }
+
+        if (folded == NO_VALUE && (passes & OPTIMIZE_COMMON)) {
+            if (type != GateType::NOT && a > b) {
+                std::swap(a, b);
+            }
+
+            uint64_t key = ((uint64_t)(a + 4) << 34) ^ ((uint64_t)(b + 4) << 3) ^ (uint64_t)type;
+            auto it = common.find(key);
+            if (it != common.end()) {
+                folded = it->second;
+                result.mergedGates++;
+            }
+            else {
+                common.emplace(key, g);
+            }
+        }
+
+        if (folded != NO_VALUE) {
+            value[g] = folded;
+        }
+        else {
+            value[g] = g;
+            types[g] = type;
+            inA[g] = a;
+            inB[g] = b;
+        }
+    }
+
+    // what the lights read, plus the switches
+    std::vector<char> live(n, 0);
+    for (int g = 0; g < n; g++) {
+        bool io = types[g] == GateType::SWITCH || types[g] == GateType::LIGHT;
+        if (value[g] == g && (io || !(passes & OPTIMIZE_DEAD_GATES))) {
+            live[g] = 1;
+            work.push_back(g);
+        }
+    }
+    while (!work.empty()) {
+        int g = work.back();
+        work.pop_back();
+        for (int v : { inA[g], inB[g] }) {
+            if (v >= 0 && !live[v]) {
+                live[v] = 1;
+                work.push_back(v);
+            }
+        }
+    }
+
+    Netlist& out = result.netlist;
+    std::vector<int> newIndex(n, -1);
+    bool needsOne = false;
+
+    for (int g = 0; g < n; g++) {
+        if (!live[g]) {
+            if (value[g] == g) {
+                result.deadGates++;
+            }
+            continue;
+        }
+
+        newIndex[g] = out.gateCount();
+        out.types.push_back(types[g]);
+        out.origins.push_back(netlist.origins[g]);
+        needsOne = needsOne || inA[g] == CONSTANT_1 || inB[g] == CONSTANT_1;
+    }
+
+    // constant 1 is a NOT gate reading nothing
+    int one = -1;
+    if (needsOne) {
+        one = out.gateCount();
+        out.types.push_back(GateType::NOT);
+        out.origins.push_back(nullptr);
+    }
+
+    auto inputNet = [&](int v) {
+        if (v == CONSTANT_0) { return -1; }
+        if (v == CONSTANT_1) { return one; }
+        return newIndex[v];
+    };
+
+    out.inputNets.reserve(out.gateCount() * NETLIST_MAX_INPUTS);
+    for (int g = 0; g < n; g++) {
+        if (live[g]) {
+            out.inputNets.push_back(inputNet(inA[g]));
+            out.inputNets.push_back(inputNet(inB[g]));
+        }
+    }
+    if (needsOne) {
+        out.inputNets.push_back(-1);
+        out.inputNets.push_back(-1);
+    }
+
+    for (int net : netlist.primaryInputs) {
+        out.primaryInputs.push_back(newIndex[net]);
+    }
+    for (int net : netlist.primaryOutputs) {
+        out.primaryOutputs.push_back(newIndex[net]);
+    }
+
+    buildFanout(out);
+
+    result.netMap.assign(n, NETLIST_REMOVED_NET);
+    result.netInverted.assign(n, 0);
+
+    for (int g = 0; g < n; g++) {
+        int v = value[g];
+
+        if (isConstant(v)) {
+            result.netMap[g] = -1;
+            result.netInverted[g] = v == CONSTANT_1;
+        }
+        else if (newIndex[v] != -1) {
+            result.netMap[g] = newIndex[v];
+        }
+        else if (types[v] == GateType::NOT && (isConstant(inA[v]) || newIndex[inA[v]] != -1)) {
+            // a dead inverter is the complement of its input
+            result.netMap[g] = isConstant(inA[v]) ? -1 : newIndex[inA[v]];
+            result.netInverted[g] = inA[v] != CONSTANT_1;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Netlist.h"
+
+#include <vector>
+
+// Passes of optimizeNetlist, combined with |
+#define OPTIMIZE_CONSTANTS 1   // gates with constant inputs (unconnected pins read 0) fold to constants or wires
+#define OPTIMIZE_INVERSIONS 2  // NOT(NOT(x)) reads x
+#define OPTIMIZE_COMMON 4      // gates of the same type on the same inputs are merged, AND(x, x) reads x ...
+#define OPTIMIZE_DEAD_GATES 8  // gates no light depends on are dropped
+#define OPTIMIZE_ALL 15
+
+#define NETLIST_REMOVED_NET -2 // in OptimizedNetlist::netMap, a net nothing computes any more
+
+// A netlist with the redundant gates gone, and where each net of the original went.
+//
+// Switches and lights are kept, in the same order, so inputs and outputs keep their indices.
+// Gates that feed a feedback loop (latches) are left exactly as they are, with their inputs : under delta
+// cycle simulation a latch depends on the lengths of the paths into it (see the D latch in
+// CircuitGenerator.cpp), so only logic between the loops and the lights is rewritten.
+struct OptimizedNetlist {
+    Netlist netlist;
+
+    // Original net i has the value of optimized net netMap[i] (constant 0 when -1), complemented when
+    // netInverted[i] is set. NETLIST_REMOVED_NET when it was dead logic.
+    std::vector<int> netMap;
+    std::vector<char> netInverted;
+
+    int foldedGates;    // replaced by a constant or by one of their inputs
+    int inversions;     // double inversions removed
+    int mergedGates;    // duplicates of another gate
+    int deadGates;      // removed, no light read them
+
+    // Value of original net `net` from the optimized simulation's net states, for showing the original
+    // circuit. False for removed nets.
+    bool originalState(const std::vector<char>& netStates, int net) const {
+        int mapped = netMap[net];
+        if (mapped == NETLIST_REMOVED_NET) {
+            return false;
+        }
+        bool value = mapped >= 0 && netStates[mapped] != 0;
+        return value != (netInverted[net] != 0);
+    }
+};
+
+// The settled outputs of the result are those of the original for every input; the number of delta
+// cycles taken to get there usually drops.
+OptimizedNetlist optimizeNetlist(const Netlist& netlist, unsigned passes = OPTIMIZE_ALL);
@@ -0,0 +1,39 @@
+#include "ParallelSimulation.h"
+
+ParallelSimulation::ParallelSimulation(const Netlist& netlist, ThreadPool& _pool) : pool(_pool) {
+    int n = netlist.gateCount();
+
+    netStates.assign(n + 1, 0);
+    inputs = netlist.primaryInputs;
+    outputs = netlist.primaryOutputs;
+
+    if (!levelize(netlist, levelization)) {
+        return;
+    }
+
+    // ops are built straight from the level order, so level boundaries carry over as is
+    buildLevelizedOps(netlist, levelization, n, ops);
+    opLevelStart = levelization.levelStart;
+
+    evaluate();
+}
+
+void ParallelSimulation::evaluate() {
+    uint8_t* nets = netStates.data();
+    const LevelizedOp* base = ops.data();
+
+    int levels = (int)opLevelStart.size() - 1;
+    for (int l = 0; l < levels; l++) {
+        int begin = opLevelStart[l];
+        int count = opLevelStart[l + 1] - begin;
+
+        if (count < PARALLEL_MIN_LEVEL_SIZE) {
+            evaluateLevelizedOps(base + begin, base + begin + count, nets);
+            continue;
+        }
+
+        pool.parallelFor(count, PARALLEL_GRAIN, [&](int from, int to) {
+            evaluateLevelizedOps(base + begin + from, base + begin + to, nets);
+        });
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "LevelizedSimulation.h"
+#include "ThreadPool.h"
+
+#include <cstdint>
+#include <vector>
+
+#define PARALLEL_MIN_LEVEL_SIZE 4096 // smaller levels are not worth waking the pool for
+#define PARALLEL_GRAIN 1024
+
+// LevelizedSimulation spread over a ThreadPool. Gates of one level never read each other,
+// so each level is cut into slices evaluated in parallel, with a barrier before the next level.
+// Every net is written by exactly one op, so the result is identical to the single threaded engine.
+class ParallelSimulation {
+private:
+    ThreadPool& pool;
+
+    std::vector<LevelizedOp> ops;
+    std::vector<int> opLevelStart; // ops of level l are ops[opLevelStart[l] .. opLevelStart[l + 1])
+    std::vector<int> inputs;
+    std::vector<int> outputs;
+
+public:
+    std::vector<uint8_t> netStates; // one extra net at the end, always 0
+
+    Levelization levelization;
+
+    ParallelSimulation(const Netlist& netlist, ThreadPool& _pool);
+
+    bool isValid() {
+        return levelization.isCombinational();
+    }
+
+    void setInput(int index, bool state) {
+        netStates[inputs[index]] = state;
+    }
+
+    bool getOutput(int index) {
+        return netStates[outputs[index]] != 0;
+    }
+
+    void evaluate();
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "LevelizedSimulation.h"
+
+#include <cstdint>
+#include <vector>
+
+// Bit-parallel version of LevelizedSimulation : every net holds Words x 64 bits, one bit per
+// independent input pattern, so one pass evaluates Words * 64 vectors with plain bitwise ops.
+//
+// The per-op loops have a compile-time trip count, so with Words = 4 or 8 the compiler turns them
+// into AVX2 / AVX-512 instructions when those are enabled (/arch:AVX2, -mavx2, ...).
+template<int Words>
+class PatternSimulation {
+private:
+    std::vector<LevelizedOp> ops;
+    std::vector<int> inputs;
+    std::vector<int> outputs;
+
+public:
+    static const int Patterns = Words * 64;
+
+    std::vector<uint64_t> netStates; // Words per net, one extra constant zero net at the end
+
+    Levelization levelization;
+
+    PatternSimulation(const Netlist& netlist) {
+        int n = netlist.gateCount();
+
+        netStates.assign((size_t)(n + 1) * Words, 0);
+        inputs = netlist.primaryInputs;
+        outputs = netlist.primaryOutputs;
+
+        if (levelize(netlist, levelization)) {
+            buildLevelizedOps(netlist, levelization, n, ops);
+        }
+    }
+
+    bool isValid() {
+        return levelization.isCombinational();
+    }
+
+    // Bits of input `index` for patterns word * 64 .. word * 64 + 63
+    void setInput(int index, int word, uint64_t bits) {
+        netStates[(size_t)inputs[index] * Words + word] = bits;
+    }
+
+    uint64_t getOutput(int index, int word) {
+        return netStates[(size_t)outputs[index] * Words + word];
+    }
+
+    void evaluate() {
+        uint64_t* nets = netStates.data();
+
+        for (const LevelizedOp& op : ops) {
+            const uint64_t* a = nets + (size_t)op.a * Words;
+            const uint64_t* b = nets + (size_t)op.b * Words;
+            uint64_t* o = nets + (size_t)op.out * Words;
+
+            switch (op.type) {
+                case GateType::OR:
+                    for (int w = 0; w < Words; w++) { o[w] = a[w] | b[w]; }
+                    break;
+                case GateType::AND:
+                    for (int w = 0; w < Words; w++) { o[w] = a[w] & b[w]; }
+                    break;
+                case GateType::XOR:
+                    for (int w = 0; w < Words; w++) { o[w] = a[w] ^ b[w]; }
+                    break;
+                case GateType::NOT:
+                    for (int w = 0; w < Words; w++) { o[w] = ~a[w]; }
+                    break;
+                default: // LIGHT
+                    for (int w = 0; w < Words; w++) { o[w] = a[w]; }
+                    break;
+            }
+        }
+    }
+};
+
+typedef PatternSimulation<1> PatternSimulation64;
+typedef PatternSimulation<4> PatternSimulation256;
+typedef PatternSimulation<8> PatternSimulation512;
+
+// Input bits for exhaustive enumeration : pattern p gives input i the value of bit (inputCount - 1 - i) of p,
+// so input 0 is the most significant bit, matching how vectors are written.
+inline uint64_t exhaustiveInputBits(int input, int inputCount, uint64_t firstPattern) {
+    static const uint64_t lowMasks[6] = {
+        0xAAAAAAAAAAAAAAAAull, 0xCCCCCCCCCCCCCCCCull, 0xF0F0F0F0F0F0F0F0ull,
+        0xFF00FF00FF00FF00ull, 0xFFFF0000FFFF0000ull, 0xFFFFFFFF00000000ull
+    };
+
+    int bit = inputCount - 1 - input;
+    if (bit < 6) {
+        return lowMasks[bit];
+    }
+
+    return ((firstPattern >> bit) & 1) ? ~0ull : 0ull;
+}
@@ -0,0 +1,102 @@
+#include "Pin.h"
+#include "Gate.h"
+#include "Metrics.h"
+#include "Simulation.h"
+
+#include <utility>
+
+FanoutTable* const Pin::defaultFanout = new FanoutTable();
+
+void Pin::update(bool state) {
+    if (cachedState == state) { return; }
+
+    cachedState = state;
+
+    if (waveformSignal != -1) {
+        Simulation::recordChange(waveformSignal, state);
+    }
+
+    if (pinType == PinType::Input) {
+        if (parentGate != nullptr) {
+            Metrics::countEvaluation();
+            parentGate->updateState(this);// propagate into component
+        }
+    }
+    if (pinType == PinType::Output) {
+        for (auto other : getFanout()) {
+            Simulation::queueUpdate(other, state);
+        }
+    }
+}
+
+void Pin::connectPins(Pin* A, Pin* B) {
+    if (A->pinType == PinType::Output) {
+        std::swap(A, B);
+    }
+
+    // A is input, B is output
+
+    A->disconnectAll();
+
+    A->connectedTo = B;
+
+    FanoutTable* table = B->parentGate->fanout;
+    if (B->fanoutList == -1) {
+        B->fanoutList = table->addList();
+    }
+    table->add(B->fanoutList, A);
+
+    if (B->cachedState) {
+        A->update(B->cachedState); // TODO : should it be and immediate ->update on the pin ? or queue an update for later ?
+    }
+}
+
+void Pin::disconnectAll() {
+    if (pinType == PinType::Input) {
+        if (connectedTo == nullptr) { return; }
+        connectedTo->parentGate->fanout->remove(connectedTo->fanoutList, this);
+        connectedTo = nullptr;
+        update(false); // TODO : should it be and immediate ->update on the pin ? or queue an update for later ?
+        return;
+    }
+    if (pinType == PinType::Output) {
+        if (fanoutList == -1) { return; }
+        for (auto other : getFanout()) {
+            other->connectedTo = nullptr;
+            other->update(false); // TODO : should it be and immediate ->update on the pin ? or queue an update for later ?
+        }
+        parentGate->fanout->clear(fanoutList);
+        return;
+    }
+}
+
+Pin::Pin() : Pin(PinType::Input) {
+}
+
+Pin::Pin(PinType pt) {
+    connectedTo = nullptr;
+    parentGate = nullptr;
+
+    pinType = pt;
+
+    cachedState = false;
+
+    waveformSignal = -1;
+    fanoutList = -1;
+    fanoutSlot = -1;
+}
+
+// Unlinks the pin from both sides, without updating anything : an input pin leaves the list of its
+// driver, the input pins an output pin drives are left unconnected
+Pin::~Pin() {
+    if (pinType == PinType::Input && connectedTo != nullptr) {
+        connectedTo->parentGate->fanout->remove(connectedTo->fanoutList, this);
+    }
+    if (pinType == PinType::Output && fanoutList != -1) {
+        for (auto other : getFanout()) {
+            other->connectedTo = nullptr;
+            other->fanoutSlot = -1;
+        }
+        parentGate->fanout->releaseList(fanoutList);
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Fanout.h"
+
+#include <cstdint>
+
+class Gate;
+
+enum class PinType : uint8_t {
+    Input,
+    Output
+};
+
+// Gates embed their pins, so pins are what the simulator walks. Members are ordered so the small
+// ones share one word : 32 bytes, no padding. What an output pin drives is kept in the FanoutTable
+// of its gate (Gate::fanout).
+class Pin {
+public:
+    Pin* connectedTo; // for input pins
+    Gate* parentGate;
+    int waveformSignal; // WaveformRecorder signal of this pin while Simulation::recorder records it, else -1
+    int fanoutList; // for output pins, list in the table of parentGate, -1 until first connected
+    int fanoutSlot; // for connected input pins, place in the list of connectedTo
+    PinType pinType;
+    bool cachedState;
+
+    // Table of the gates made with new. Never deleted : such gates may be destroyed after every other static.
+    static FanoutTable* const defaultFanout;
+
+    // The input pins an output pin drives. Defined in Gate.h, it reads the gate's table.
+    inline FanoutRange getFanout() const;
+
+    void update(bool state);
+    void static connectPins(Pin* A, Pin* B);
+    void disconnectAll();
+    Pin();
+    Pin(PinType pt);
+    ~Pin();
+
+    // a pin's fanout list and slot belong to it
+    Pin(const Pin&) = delete;
+    Pin& operator=(const Pin&) = delete;
+};
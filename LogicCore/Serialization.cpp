@@ -0,0 +1,268 @@
+#include "Serialization.h"
+#include "IntegratedChip.h"
+#include "Simulation.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <set>
+#include <utility>
+
+// Depth first over the chip definitions : a circuit is listed once all the circuits it uses are, so
+// a definition shared by several chips, at any depth, comes out once and before each of its users
+std::vector<CircuitPtr> topoSort(const CircuitPtr circuit) {
+    std::vector<CircuitPtr> circuitList;
+
+    std::set<CircuitPtr> visited;
+    std::vector<std::pair<CircuitPtr, size_t>> stack; // circuit, next gate to look at
+
+    visited.insert(circuit);
+    stack.push_back(std::make_pair(circuit, (size_t)0));
+
+    while (!stack.empty()) {
+        CircuitPtr top = stack.back().first;
+        size_t next = stack.back().second;
+
+        if (next == top->size()) {
+            circuitList.push_back(top); // post-order
+            stack.pop_back();
+            continue;
+        }
+
+        stack.back().second++;
+
+        IntegratedChip* ic = dynamic_cast<IntegratedChip*>((*top)[next]);
+        if (ic == nullptr) { continue; }
+
+        CircuitPtr inner = ic->definition->getCircuit();
+        if (visited.insert(inner).second) {
+            stack.push_back(std::make_pair(inner, (size_t)0));
+        }
+    }
+
+    return circuitList;
+}
+
+
+int getIndex(const std::vector<CircuitPtr>& v, CircuitPtr K)
+{
+    auto it = std::find(v.begin(), v.end(), K);
+
+    // If element was found
+    if (it != v.end())
+    {
+
+        // calculating the index
+        // of K
+        int index = it - v.begin();
+        return index;
+    }
+    else {
+        return -1;
+    }
+}
+
+
+
+Gate* newGateOfType(GateType type, GatePool* pool) {
+    if (pool != nullptr) {
+        return pool->createOfType(type);
+    }
+
+    switch (type) {
+        case GateType::OR:
+            return new ORGate();
+        case GateType::AND:
+            return new ANDGate();
+        case GateType::NOT:
+            return new NOTGate();
+        case GateType::XOR:
+            return new XORGate();
+        case GateType::SWITCH:
+            return new Switch();
+        case GateType::LIGHT:
+            return new Light();
+        default:
+            break;
+    }
+
+    return nullptr;
+}
+
+Gate* newChip(ChipDefinition* definition, GatePool* pool) {
+    if (pool != nullptr) {
+        return pool->createChip(definition);
+    }
+
+    return new IntegratedChip(definition);
+}
+
+void loadFromFile(std::vector<Gate*>& gates, std::istream& inputStream, std::vector<ChipDefinition*>* definitions, GatePool* pool) {
+    int gateCount;
+
+    inputStream >> gateCount;
+
+    std::map<int, Gate*> gatesByIndex;
+
+    for (int i = 0; i < gateCount; i++) {
+        int gateID; // note : really, can get rid of this because all the id's are in incrementing order 0, 1, 2 ...
+        int gateType;
+        Vec2f position;
+
+        inputStream >> gateID >> gateType;
+
+        int circuitID = -1;
+        if (gateType == (int)GateType::INTEGRATED){
+            inputStream >> circuitID >> position.x >> position.y;
+        }
+        else {
+            inputStream >> position.x >> position.y;
+        }
+
+
+        LGS_TRACE(gateID << " " << gateType << " " << circuitID << " " << position.x << " " << position.y);
+
+        Gate* newGate;
+
+        if (circuitID != -1) {
+            newGate = newChip((*definitions)[circuitID], pool);
+        }
+        else {
+            newGate = newGateOfType((GateType)gateType, pool);
+        }
+
+
+        newGate->position(position);
+
+        gatesByIndex[gateID] = newGate;
+
+        gates.push_back(newGate);
+    }
+
+    int connectionCount;
+
+    inputStream >> connectionCount;
+
+    for (int i = 0; i < connectionCount; i++) {
+        // gate A -> gate B
+
+        int gateA, gateB, pinA, pinB;
+
+        inputStream >> gateB >> pinB >> gateA >> pinA;
+
+        Pin* outputPin = gatesByIndex[gateA]->getPinByIndex(PinType::Output, pinA);
+        Pin* inputPin = gatesByIndex[gateB]->getPinByIndex(PinType::Input, pinB);
+
+        Pin::connectPins(outputPin, inputPin);
+    }
+}
+
+void saveToFile(const std::vector<Gate*> & gates, std::ostream & outputStream, std::vector<CircuitPtr>* circuitList) {
+    std::map<Gate*, int> gateNumbers;
+
+    int counter = 0;
+    int totalConnections = 0;
+    for (auto gate : gates) {
+        gateNumbers[gate] = counter;
+        counter++;
+
+        int c = gate->getInputPinCount();
+        Pin* pins = gate->getInputPins();
+        for (int i = 0; i < c; i++) {
+            if (pins[i].connectedTo != nullptr) {
+                totalConnections++;
+            }
+        }
+    }
+
+    outputStream << counter << std::endl;
+
+    for (auto gate : gates) {
+        auto pos = gate->getPosition();
+
+        IntegratedChip* ic = dynamic_cast<IntegratedChip*>(gate);
+        if (ic != nullptr) {
+            int circuitIndex = getIndex(*circuitList, ic->definition->getCircuit());
+            if (circuitIndex == -1) {
+                std::cerr << "ERROR : index is -1 on lookup circuits" << std::endl;
+            }
+            outputStream << gateNumbers[gate] << " " << (int)gate->getGateType() << " " << circuitIndex << " " << pos.x << " " << pos.y << std::endl;
+        }
+        else {
+            outputStream << gateNumbers[gate] << " " << (int)gate->getGateType() << " " << pos.x << " " << pos.y << std::endl;
+        }
+    }
+
+    outputStream << totalConnections << std::endl;
+
+    for (auto gate : gates) {
+        int c = gate->getInputPinCount();
+        Pin* pins = gate->getInputPins();
+        for (int i = 0; i < c; i++) {
+            Pin* outputPin = pins[i].connectedTo;
+            if (outputPin != nullptr) {
+                int tempIndex = 0;
+                if (outputPin->parentGate->getPinIndex(outputPin, PinType::Output, tempIndex)) {
+                    outputStream << gateNumbers[gate] << " " << i << " " << gateNumbers[outputPin->parentGate] << " " << tempIndex << std::endl;
+                }
+                else {
+                    std::cerr << "======FAIL TO REVERSE LOOKUP PIN INDEX========" << std::endl;
+                }
+            }
+        }
+    }
+}
+
+
+
+void saveToFileRecursively(std::vector<Gate*>& gates, std::ostream& outputStream) {
+    auto list = topoSort(&gates);
+
+    outputStream << list.size() << std::endl; // or capacity ??
+
+    int counter = 0;
+
+    LGS_TRACE("Performed topo sort on " << &gates);
+    for (CircuitPtr circuit : list) {
+        LGS_TRACE("Serializing circuit " << circuit);
+        outputStream << counter << std::endl;
+        saveToFile(*circuit, outputStream, &list);
+        counter++;
+    }
+}
+
+void loadFromFileRecursively(std::vector<Gate*>& gates, std::istream& inputStream, GatePool* pool, std::vector<ChipDefinition*>* made) {
+    int circuitCount;
+
+    inputStream >> circuitCount;
+
+    std::vector<ChipDefinition*> definitions;
+
+    for (int currentCircuitID = 0; currentCircuitID < circuitCount; currentCircuitID++) {
+        int circuitID;
+        inputStream >> circuitID;
+
+        if (currentCircuitID == circuitCount - 1) { // if the last one
+            loadFromFile(gates, inputStream, &definitions, pool);
+        }
+        else {
+            std::vector<Gate*>* newCircuit = new std::vector<Gate*>();
+            GatePool* circuitPool = new GatePool(GATE_POOL_SMALL_BLOCK_SIZE);
+            Simulation::suspend();
+            loadFromFile(*newCircuit, inputStream, &definitions, circuitPool);
+            Simulation::resume();
+            definitions.push_back(new ChipDefinition(newCircuit, "CHIP", circuitPool));
+            if (made != nullptr) {
+                made->push_back(definitions.back());
+            }
+        }
+    }
+}
+
+void deleteDefinitions(std::vector<ChipDefinition*>& definitions) {
+    for (auto it = definitions.rbegin(); it != definitions.rend(); ++it) {
+        delete *it;
+    }
+    definitions.clear();
+}
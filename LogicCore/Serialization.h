@@ -0,0 +1,33 @@
+#pragma once
+
+#include "ChipDefinition.h"
+#include "Gate.h"
+#include "GatePool.h"
+
+#include <istream>
+#include <ostream>
+#include <vector>
+
+typedef std::vector<Gate*>* CircuitPtr;
+
+// circuit and the circuits of its chips, each once, the ones a circuit uses before it
+std::vector<CircuitPtr> topoSort(const CircuitPtr circuit);
+
+int getIndex(const std::vector<CircuitPtr>& v, CircuitPtr K);
+
+// The loaders make gates with these : in pool when one is given, else with new (the caller deletes them)
+Gate* newGateOfType(GateType type, GatePool* pool = nullptr);
+Gate* newChip(ChipDefinition* definition, GatePool* pool = nullptr);
+
+void loadFromFile(std::vector<Gate*>& gates, std::istream& inputStream, std::vector<ChipDefinition*>* definitions = nullptr, GatePool* pool = nullptr);
+void saveToFile(const std::vector<Gate*> & gates, std::ostream & outputStream, std::vector<CircuitPtr>* circuitList = nullptr);
+
+void saveToFileRecursively(std::vector<Gate*>& gates, std::ostream& outputStream);
+
+// The top level gates are made in pool. Each chip circuit nested in the file gets a definition owning
+// its own pool, appended to made, users after the definitions they use : the caller deletes them
+// with deleteDefinitions once the gates are gone. Without made they live until the program ends.
+void loadFromFileRecursively(std::vector<Gate*>& gates, std::istream& inputStream, GatePool* pool = nullptr, std::vector<ChipDefinition*>* made = nullptr);
+
+// Deletes definitions in the order a loader made them, last first, and empties the list
+void deleteDefinitions(std::vector<ChipDefinition*>& definitions);
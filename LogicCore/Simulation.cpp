@@ -0,0 +1,118 @@
+#include "Simulation.h"
+#include "Metrics.h"
+#include "Pin.h"
+#include "TopologicalOrder.h"
+#include "Trace.h"
+#include "WaveformRecorder.h"
+
+#include <chrono>
+
+std::queue<SimulationUpdate> Simulation::updateQueue;
+#ifdef TRY_RUN_EVERYTHING_ONCE
+int Simulation::updatesThisFrame = 0;
+#endif
+int Simulation::suspendCount = 0;
+
+SteppingMode Simulation::steppingMode = SteppingMode::DeltaCycles;
+int Simulation::cyclesPerStep = 1;
+int Simulation::settleEventCap = 1000000;
+double Simulation::turboBudgetMs = 12.0;
+bool Simulation::oscillating = false;
+unsigned long long Simulation::tickCount = 0;
+WaveformRecorder* Simulation::recorder = nullptr;
+TopologicalOrder* Simulation::order = nullptr;
+
+void Simulation::queueUpdate(Pin * pin, bool newState) {
+    if (suspendCount > 0) { return; }
+
+    updateQueue.emplace(pin, newState);
+
+#ifdef TRY_RUN_EVERYTHING_ONCE
+    updatesThisFrame++;
+#endif
+
+    Metrics::sampleQueueDepth(updateQueue.size());
+    LGS_TRACE("Size of queue " << updateQueue.size());
+}
+
+void Simulation::recordChange(int signal, bool state) {
+    if (recorder != nullptr) {
+        recorder->change(tickCount, signal, state);
+    }
+}
+
+int Simulation::processTick() {
+    int processed = 0;
+
+    if (!updateQueue.empty()) {
+        tickCount++;
+    }
+
+#ifdef TRY_RUN_EVERYTHING_ONCE
+    int i = updatesThisFrame;
+    updatesThisFrame = 0;
+    for (; i > 0; i--) {
+#endif
+        if (updateQueue.size() == 0) { break; }
+        updateQueue.front().affectedPin->update(updateQueue.front().newState);
+        updateQueue.pop();
+        processed++;
+#ifdef TRY_RUN_EVERYTHING_ONCE
+    }
+#endif
+
+    Metrics::countEvents(processed);
+
+    return processed;
+}
+
+bool Simulation::settle(int eventCap) {
+    int events = 0;
+
+    while (!updateQueue.empty()) {
+        if (events > eventCap) {
+            oscillating = true;
+            return false;
+        }
+        events += processTick();
+    }
+
+    oscillating = false;
+    return true;
+}
+
+void Simulation::step() {
+    Metrics::beginStep();
+
+    switch (steppingMode) {
+        case SteppingMode::DeltaCycles:
+            for (int i = 0; i < cyclesPerStep && !updateQueue.empty(); i++) {
+                processTick();
+            }
+            break;
+        case SteppingMode::Settle:
+            if (order != nullptr && order->getFeedbackCount() == 0) {
+                if (!updateQueue.empty()) {
+                    tickCount++;
+                }
+                Metrics::countEvents(order->settle());
+#ifdef TRY_RUN_EVERYTHING_ONCE
+                updatesThisFrame = 0;
+#endif
+                oscillating = false;
+                break;
+            }
+            settle(settleEventCap);
+            break;
+        case SteppingMode::Turbo: {
+            auto start = std::chrono::steady_clock::now();
+            auto budget = std::chrono::duration<double, std::milli>(turboBudgetMs);
+            while (!updateQueue.empty() && std::chrono::steady_clock::now() - start < budget) {
+                processTick();
+            }
+            break;
+        }
+    }
+
+    Metrics::endStep();
+}
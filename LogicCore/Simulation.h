@@ -0,0 +1,88 @@
+#pragma once
+
+#include <queue>
+
+class Pin;
+class TopologicalOrder;
+class WaveformRecorder;
+
+struct SimulationUpdate {
+public:
+    Pin * affectedPin;
+    bool newState;
+    SimulationUpdate(Pin* pin, bool state)// : affectedPin(pin), newState(state)
+    {
+        affectedPin = pin;
+        newState = state;
+    }
+};
+
+// not working
+#define TRY_RUN_EVERYTHING_ONCE
+
+// How much simulation step() runs per call (the GUI calls it once per frame).
+enum class SteppingMode {
+    DeltaCycles, // cyclesPerStep delta cycles
+    Settle,      // until the queue is empty, at most settleEventCap events (in order, see Simulation::order)
+    Turbo        // as many delta cycles as fit in turboBudgetMs
+};
+
+class Simulation {
+private:
+    Simulation();
+
+public:
+    static std::queue<SimulationUpdate> updateQueue;
+
+#ifdef TRY_RUN_EVERYTHING_ONCE
+    static int updatesThisFrame;
+#endif
+
+    // While suspended, queueUpdate drops events. Used while loading chip definitions : their circuits
+    // are templates that are never simulated, so their gates must not feed the queue. Calls nest.
+    static int suspendCount;
+
+    static void suspend() {
+        suspendCount++;
+    }
+
+    static void resume() {
+        suspendCount--;
+    }
+
+    static void queueUpdate(Pin * pin, bool newState);
+
+    // One delta cycle : the events queued since the previous tick. Returns how many were processed.
+    static int processTick();
+
+    static SteppingMode steppingMode;
+    static int cyclesPerStep;
+    static int settleEventCap;
+    static double turboBudgetMs;
+
+    // Set when the last step hit settleEventCap with events still queued : the circuit oscillates.
+    static bool oscillating;
+
+    // Delta cycles run so far, the time axis of recorded waveforms
+    static unsigned long long tickCount;
+
+    // Receives the changes of every pin with a waveformSignal. Null when not recording.
+    static WaveformRecorder* recorder;
+
+    // Order of the circuit being simulated, kept up to date by its editor. Null when there is none.
+    // While it has no feedback edge, Settle mode runs the queue with TopologicalOrder::settle, in one
+    // delta cycle : every pin changes at most once, instead of once per glitch.
+    static TopologicalOrder* order;
+
+    static void recordChange(int signal, bool state);
+
+    static bool isIdle() {
+        return updateQueue.empty();
+    }
+
+    // Runs delta cycles until the queue is empty. Returns false if more than eventCap events were needed.
+    static bool settle(int eventCap);
+
+    // Runs one step in steppingMode. Each step is one Metrics step.
+    static void step();
+};
@@ -0,0 +1,129 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int threadCount) {
+    if (threadCount <= 0) {
+        threadCount = (int)std::thread::hardware_concurrency();
+        if (threadCount <= 0) {
+            threadCount = 1;
+        }
+    }
+
+    generation = 0;
+    stopping = false;
+    job = nullptr;
+    remaining = 0;
+
+    // the calling thread takes part in every job, so it counts as one of the threads
+    for (int i = 0; i < threadCount; i++) {
+        queues.push_back(new WorkQueue());
+    }
+    for (int i = 1; i < threadCount; i++) {
+        threads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto& t : threads) {
+        t.join();
+    }
+    for (auto q : queues) {
+        delete q;
+    }
+}
+
+bool ThreadPool::takeChunk(int self, Chunk& out) {
+    {
+        WorkQueue* own = queues[self];
+        std::lock_guard<std::mutex> lock(own->mutex);
+        if (!own->chunks.empty()) {
+            out = own->chunks.back();
+            own->chunks.pop_back();
+            return true;
+        }
+    }
+
+    int n = (int)queues.size();
+    for (int i = 1; i < n; i++) {
+        WorkQueue* victim = queues[(self + i) % n];
+        std::lock_guard<std::mutex> lock(victim->mutex);
+        if (!victim->chunks.empty()) {
+            out = victim->chunks.front();
+            victim->chunks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::runChunks(int self) {
+    Chunk chunk;
+    while (takeChunk(self, chunk)) {
+        (*job)(chunk.begin, chunk.end);
+        remaining.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+void ThreadPool::workerLoop(int self) {
+    unsigned seen = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) { return; }
+            seen = generation;
+        }
+
+        runChunks(self);
+    }
+}
+
+void ThreadPool::parallelFor(int count, int grain, const std::function<void(int, int)>& fn) {
+    if (count <= 0) { return; }
+    if (grain <= 0) {
+        grain = 1;
+    }
+
+    int chunkCount = (count + grain - 1) / grain;
+
+    if (chunkCount == 1 || threads.empty()) {
+        fn(0, count);
+        return;
+    }
+
+    job = &fn;
+    remaining.store(chunkCount, std::memory_order_release);
+
+    int n = (int)queues.size();
+    for (int c = 0; c < chunkCount; c++) {
+        Chunk chunk;
+        chunk.begin = c * grain;
+        chunk.end = chunk.begin + grain < count ? chunk.begin + grain : count;
+
+        WorkQueue* q = queues[c % n];
+        std::lock_guard<std::mutex> lock(q->mutex);
+        q->chunks.push_back(chunk);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        generation++;
+    }
+    wake.notify_all();
+
+    runChunks(0);
+
+    // everything is taken, wait for the chunks still running elsewhere
+    while (remaining.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+    }
+
+    job = nullptr;
+}
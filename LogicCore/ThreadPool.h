@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads running parallelFor jobs. Chunks are dealt round-robin into per-worker
+// queues; a worker takes from the back of its own queue and steals from the front of the others
+// when it runs dry, so uneven chunks still keep every core busy.
+class ThreadPool {
+private:
+    struct Chunk {
+        int begin, end;
+    };
+
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Chunk> chunks;
+    };
+
+    std::vector<std::thread> threads;
+    std::vector<WorkQueue*> queues; // one per worker, plus one for the calling thread
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    unsigned generation;
+    bool stopping;
+
+    const std::function<void(int, int)>* job;
+    std::atomic<int> remaining;
+
+    bool takeChunk(int self, Chunk& out);
+    void runChunks(int self);
+    void workerLoop(int self);
+
+public:
+    // 0 threads means one per hardware thread
+    ThreadPool(int threadCount = 0);
+    ~ThreadPool();
+
+    int size() {
+        return (int)threads.size() + 1;
+    }
+
+    // Calls fn(begin, end) on slices of [0, count) at most `grain` long, using the pool and the calling
+    // thread. Returns once every slice has run. Not reentrant.
+    void parallelFor(int count, int grain, const std::function<void(int, int)>& fn);
+};
@@ -0,0 +1,444 @@
+#include "TopologicalOrder.h"
+#include "IntegratedChip.h"
+#include "Simulation.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+TopologicalOrder::TopologicalOrder() {
+    gateCount = 0;
+}
+
+// Nodes of a gate : one, or for a chip one per output and the one of its inputs, last
+static int nodeCount(Gate* gate) {
+    return gate->getGateType() == GateType::INTEGRATED ? gate->getOutputPinCount() + 1 : 1;
+}
+
+int TopologicalOrder::addGate(Gate* gate) {
+    int first = (int)nodes.size();
+    ids[gate] = first;
+
+    for (int id = first; id < first + nodeCount(gate); id++) {
+        nodes.push_back(gate);
+        successors.emplace_back();
+        predecessors.emplace_back();
+        position.push_back(id);
+        level.push_back(0);
+        visited.push_back(0);
+
+        if (levelCount.empty()) {
+            levelCount.push_back(0);
+        }
+        levelCount[0]++;
+    }
+
+    return first;
+}
+
+// Gates the circuit has not shown to update yet are added on first use
+int TopologicalOrder::idOf(Gate* gate) {
+    auto it = ids.find(gate);
+    return it != ids.end() ? it->second : addGate(gate);
+}
+
+// Fills edges with the node pairs of the connection output -> input
+void TopologicalOrder::edgesOf(Pin* output, Pin* input) {
+    Gate* from = output->parentGate;
+    Gate* to = input->parentGate;
+    int source = idOf(from);
+    int sink = idOf(to);
+
+    if (from->getGateType() == GateType::INTEGRATED) {
+        source += (int)(output - from->getOutputPins());
+    }
+
+    edges.clear();
+    if (to->getGateType() != GateType::INTEGRATED) {
+        edges.push_back(std::make_pair(source, sink));
+        return;
+    }
+
+    IntegratedChip* chip = static_cast<IntegratedChip*>(to);
+    for (int o : chip->definition->getOutputsReading((int)(input - to->getInputPins()))) {
+        edges.push_back(std::make_pair(source, sink + o));
+    }
+    edges.push_back(std::make_pair(source, sink + to->getOutputPinCount()));
+}
+
+// The node an update of input waits for : the first of the nodes its connection leads to
+int TopologicalOrder::entryOf(Pin* input) {
+    Gate* gate = input->parentGate;
+    int first = idOf(gate);
+    if (gate->getGateType() != GateType::INTEGRATED) {
+        return first;
+    }
+
+    IntegratedChip* chip = static_cast<IntegratedChip*>(gate);
+    int entry = first + gate->getOutputPinCount();
+    for (int o : chip->definition->getOutputsReading((int)(input - gate->getInputPins()))) {
+        if (position[first + o] < position[entry]) {
+            entry = first + o;
+        }
+    }
+    return entry;
+}
+
+void TopologicalOrder::addEdge(int from, int to) {
+    successors[from].push_back(to);
+    predecessors[to].push_back(from);
+}
+
+// Depth first from start through the nodes placed before upper. True when it reaches upper's node :
+// the edge being inserted would close a loop.
+bool TopologicalOrder::searchForward(int start, int upper) {
+    stack.clear();
+    stack.push_back(start);
+    visited[start] = 1;
+    forward.push_back(start);
+
+    while (!stack.empty()) {
+        int node = stack.back();
+        stack.pop_back();
+
+        for (int next : successors[node]) {
+            if (position[next] == upper) {
+                return true;
+            }
+            if (!visited[next] && position[next] < upper) {
+                visited[next] = 1;
+                forward.push_back(next);
+                stack.push_back(next);
+            }
+        }
+    }
+
+    return false;
+}
+
+// Depth first backwards from start through the nodes placed after lower
+void TopologicalOrder::searchBackward(int start, int lower) {
+    stack.clear();
+    stack.push_back(start);
+    visited[start] = 1;
+    backward.push_back(start);
+
+    while (!stack.empty()) {
+        int node = stack.back();
+        stack.pop_back();
+
+        for (int previous : predecessors[node]) {
+            if (!visited[previous] && position[previous] > lower) {
+                visited[previous] = 1;
+                backward.push_back(previous);
+                stack.push_back(previous);
+            }
+        }
+    }
+}
+
+// Gives the positions held by backward and forward to backward first, then forward, each keeping
+// its relative order
+void TopologicalOrder::reorder() {
+    auto byPosition = [this](int a, int b) {
+        return position[a] < position[b];
+    };
+    std::sort(backward.begin(), backward.end(), byPosition);
+    std::sort(forward.begin(), forward.end(), byPosition);
+
+    stack.clear();
+    for (int node : backward) {
+        stack.push_back(position[node]);
+    }
+    for (int node : forward) {
+        stack.push_back(position[node]);
+    }
+    std::sort(stack.begin(), stack.end());
+
+    size_t next = 0;
+    for (int node : backward) {
+        position[node] = stack[next++];
+        visited[node] = 0;
+    }
+    for (int node : forward) {
+        position[node] = stack[next++];
+        visited[node] = 0;
+    }
+}
+
+bool TopologicalOrder::insertEdge(int from, int to) {
+    if (from == to) {
+        return false;
+    }
+
+    int lower = position[to];
+    int upper = position[from];
+
+    if (lower < upper) {
+        forward.clear();
+        backward.clear();
+
+        if (searchForward(to, upper)) {
+            for (int node : forward) {
+                visited[node] = 0;
+            }
+            return false;
+        }
+
+        searchBackward(from, lower);
+        reorder();
+    }
+
+    addEdge(from, to);
+    relevel(to);
+    return true;
+}
+
+void TopologicalOrder::setLevel(int node, int value) {
+    levelCount[level[node]]--;
+    if (value >= (int)levelCount.size()) {
+        levelCount.resize(value + 1, 0);
+    }
+    levelCount[value]++;
+    level[node] = value;
+
+    while (!levelCount.empty() && levelCount.back() == 0) {
+        levelCount.pop_back();
+    }
+}
+
+// Recomputes the level of start from its predecessors, then of the nodes after it whose level
+// changes, in order so each is computed once its predecessors are final
+void TopologicalOrder::relevel(int start) {
+    typedef std::pair<int, int> Entry; // position, node
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+
+    queue.push(Entry(position[start], start));
+    visited[start] = 1;
+
+    while (!queue.empty()) {
+        int node = queue.top().second;
+        queue.pop();
+        visited[node] = 0;
+
+        int value = 0;
+        for (int previous : predecessors[node]) {
+            value = std::max(value, level[previous] + 1);
+        }
+        if (value == level[node]) { continue; }
+
+        setLevel(node, value);
+
+        for (int next : successors[node]) {
+            if (!visited[next]) {
+                visited[next] = 1;
+                queue.push(Entry(position[next], next));
+            }
+        }
+    }
+}
+
+void TopologicalOrder::update(const std::vector<Gate*>& gates) {
+    if (gates.size() < gateCount) {
+        rebuild(gates);
+        return;
+    }
+
+    for (size_t i = gateCount; i < gates.size(); i++) {
+        Gate* gate = gates[i];
+        Pin* pins = gate->getInputPins();
+        for (int p = 0; p < gate->getInputPinCount(); p++) {
+            if (pins[p].connectedTo != nullptr) {
+                rebuild(gates);
+                return;
+            }
+        }
+    }
+
+    for (; gateCount < gates.size(); gateCount++) {
+        idOf(gates[gateCount]);
+    }
+}
+
+void TopologicalOrder::rebuild(const std::vector<Gate*>& gates) {
+    clear();
+
+    for (Gate* gate : gates) {
+        if (ids.find(gate) == ids.end()) {
+            addGate(gate);
+        }
+    }
+    gateCount = gates.size();
+
+    int n = (int)nodes.size();
+
+    std::vector<std::vector<int>> outgoing(n);
+    for (Gate* gate : gates) {
+        Pin* pins = gate->getInputPins();
+        for (int p = 0; p < gate->getInputPinCount(); p++) {
+            if (pins[p].connectedTo == nullptr || ids.find(pins[p].connectedTo->parentGate) == ids.end()) { continue; }
+
+            edgesOf(pins[p].connectedTo, pins + p);
+            for (auto& edge : edges) {
+                outgoing[edge.first].push_back(edge.second);
+            }
+        }
+    }
+
+    // 0 not seen, 1 on the path being visited, 2 done
+    std::vector<char> state(n, 0);
+    std::vector<std::pair<int, size_t>> path; // node, next edge
+    int finished = 0;
+
+    for (int root = 0; root < n; root++) {
+        if (state[root] != 0) { continue; }
+
+        state[root] = 1;
+        path.push_back(std::make_pair(root, (size_t)0));
+
+        while (!path.empty()) {
+            int node = path.back().first;
+            size_t& edge = path.back().second;
+
+            if (edge == outgoing[node].size()) {
+                state[node] = 2;
+                position[node] = n - 1 - finished++; // reverse postorder
+                path.pop_back();
+                continue;
+            }
+
+            int next = outgoing[node][edge++];
+            if (state[next] == 1) {
+                feedback.push_back(std::make_pair(node, next));
+                continue;
+            }
+
+            addEdge(node, next);
+            if (state[next] == 0) {
+                state[next] = 1;
+                path.push_back(std::make_pair(next, (size_t)0));
+            }
+        }
+    }
+
+    std::vector<int> order(n);
+    for (int node = 0; node < n; node++) {
+        order[position[node]] = node;
+    }
+    for (int node : order) {
+        int value = 0;
+        for (int previous : predecessors[node]) {
+            value = std::max(value, level[previous] + 1);
+        }
+        if (value != level[node]) {
+            setLevel(node, value);
+        }
+    }
+}
+
+void TopologicalOrder::clear() {
+    nodes.clear();
+    ids.clear();
+    gateCount = 0;
+    successors.clear();
+    predecessors.clear();
+    feedback.clear();
+    position.clear();
+    level.clear();
+    levelCount.clear();
+    visited.clear();
+}
+
+bool TopologicalOrder::connect(Pin* output, Pin* input) {
+    edgesOf(output, input);
+
+    bool closesLoop = false;
+    for (auto& edge : edges) {
+        if (!insertEdge(edge.first, edge.second)) {
+            feedback.push_back(edge);
+            closesLoop = true;
+        }
+    }
+    return !closesLoop;
+}
+
+// True when the edge was in the order, false when it was a feedback edge or unknown
+bool TopologicalOrder::removeEdge(int from, int to) {
+    auto loop = std::find(feedback.begin(), feedback.end(), std::make_pair(from, to));
+    if (loop != feedback.end()) {
+        feedback.erase(loop);
+        return false;
+    }
+
+    auto next = std::find(successors[from].begin(), successors[from].end(), to);
+    if (next == successors[from].end()) { return false; }
+    successors[from].erase(next);
+    predecessors[to].erase(std::find(predecessors[to].begin(), predecessors[to].end(), from));
+
+    relevel(to);
+    return true;
+}
+
+void TopologicalOrder::disconnect(Pin* output, Pin* input) {
+    edgesOf(output, input);
+
+    bool opened = false;
+    for (auto& edge : edges) {
+        if (removeEdge(edge.first, edge.second)) {
+            opened = true;
+        }
+    }
+
+    // the loops these edges were part of are open now
+    if (!opened || feedback.empty()) { return; }
+
+    std::vector<std::pair<int, int>> pending;
+    pending.swap(feedback);
+    for (auto& edge : pending) {
+        if (!insertEdge(edge.first, edge.second)) {
+            feedback.push_back(edge);
+        }
+    }
+}
+
+int TopologicalOrder::getPosition(Gate* gate) {
+    return position[idOf(gate)];
+}
+
+int TopologicalOrder::getLevel(Gate* gate) {
+    int first = idOf(gate);
+
+    int value = 0;
+    for (int id = first; id < first + nodeCount(gate); id++) {
+        value = std::max(value, level[id]);
+    }
+    return value;
+}
+
+int TopologicalOrder::settle() {
+    typedef std::pair<int, Pin*> Entry; // position waited for, input pin
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    int updates = 0;
+
+    for (;;) {
+        // the values queued are not used : a pin takes its source's state when its turn comes
+        while (!Simulation::updateQueue.empty()) {
+            Pin* pin = Simulation::updateQueue.front().affectedPin;
+            Simulation::updateQueue.pop();
+            if (settling.insert(pin).second) {
+                queue.push(Entry(position[entryOf(pin)], pin));
+            }
+        }
+
+        if (queue.empty()) { break; }
+
+        Pin* pin = queue.top().second;
+        queue.pop();
+        settling.erase(pin);
+
+        pin->update(pin->connectedTo != nullptr && pin->connectedTo->cachedState);
+        updates++;
+    }
+
+    return updates;
+}
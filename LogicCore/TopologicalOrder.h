@@ -0,0 +1,108 @@
+#pragma once
+
+#include "Gate.h"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// Topological order and levels of the gates of a circuit (an edge per connected input pin, from the
+// source pin's gate), kept up to date while the circuit is edited instead of sorted again after
+// every connection.
+//
+// A gate is one node, except an integrated chip : one node per output pin, and one more its inputs
+// all lead to. A connection into a chip input is an edge to that last node and to the nodes of the
+// outputs depending on the input (ChipDefinition::getOutputsReading), so a chip output wired back to
+// an input it does not depend on is not a loop.
+//
+// connect uses the Pearce-Kelly algorithm : when the new edge goes backwards in the order, only the
+// nodes placed between its two ends are searched, forwards from the sink and backwards from the
+// source, and the two sets found are renumbered among the positions they already held. Levels (longest
+// path from a node without predecessors) are recomputed from the sink onwards, in order, and only
+// as far as they change. disconnect never breaks the order, it only lowers levels.
+//
+// An edge that would close a loop (a latch, or a mistake) is kept aside as a feedback edge and left
+// out of the order and the levels; connect returns false for it. Once a disconnect opens the loop,
+// the edge is taken back.
+//
+// settle runs the simulation in the order : the levelized engine of the gate objects, see
+// Simulation::order.
+class TopologicalOrder {
+private:
+    std::vector<Gate*> nodes;
+    std::unordered_map<Gate*, int> ids; // first node of each gate
+    size_t gateCount; // gates of the circuit already added by update
+
+    std::vector<std::vector<int>> successors; // edges in the order, one entry per connection
+    std::vector<std::vector<int>> predecessors;
+    std::vector<std::pair<int, int>> feedback;
+
+    std::vector<int> position; // by node
+    std::vector<int> level;
+    std::vector<int> levelCount; // nodes per level, for getDepth
+
+    // scratch of the searches
+    std::vector<char> visited;
+    std::vector<int> forward, backward, stack;
+    std::vector<std::pair<int, int>> edges; // of the connection given to edgesOf
+
+    std::unordered_set<Pin*> settling; // pins waiting in settle
+
+    int idOf(Gate* gate);
+    int addGate(Gate* gate);
+    void addEdge(int from, int to);
+    bool insertEdge(int from, int to);
+    bool removeEdge(int from, int to);
+    bool searchForward(int start, int upper);
+    void searchBackward(int start, int lower);
+    void reorder();
+    void setLevel(int node, int value);
+    void relevel(int start);
+    void edgesOf(Pin* output, Pin* input);
+    int entryOf(Pin* input);
+
+public:
+    TopologicalOrder();
+
+    // Adds the gates appended to gates since the last call. A batch with connections (a load) is
+    // sorted from scratch, O(gates + connections).
+    void update(const std::vector<Gate*>& gates);
+
+    // Sorts gates from scratch : depth first, the edges to nodes still being visited are the feedback ones
+    void rebuild(const std::vector<Gate*>& gates);
+
+    void clear();
+
+    // After Pin::connectPins(output, input). Returns false when the connection closes a loop.
+    bool connect(Pin* output, Pin* input);
+
+    // After the connection output -> input is removed
+    void disconnect(Pin* output, Pin* input);
+
+    // Place in the order : a gate's nodes come after every node driving them, feedback edges aside.
+    // For a chip, the place of its first node.
+    int getPosition(Gate* gate);
+
+    // For a chip, the highest level of its nodes
+    int getLevel(Gate* gate);
+
+    // Levels in use, the length of the longest path
+    int getDepth() const {
+        return (int)levelCount.size();
+    }
+
+    // Edges kept aside. A connection into a chip closing a loop counts once per node it leads to.
+    int getFeedbackCount() const {
+        return (int)feedback.size();
+    }
+
+    size_t size() const {
+        return nodes.size();
+    }
+
+    // Runs the events queued in Simulation until none are left, the pin waiting first in the order
+    // first, each updated from the current state of its source. Without feedback edges every pin is
+    // updated at most once : when it is, everything before it is final. Returns the updates made.
+    int settle();
+};
@@ -0,0 +1,18 @@
+#pragma once
+
+// Debug trace points for the event loop and the loaders. They compile to nothing unless LGS_TRACE_ENABLED
+// is defined (add it to the project's preprocessor definitions), so they can stay on hot paths.
+//
+//   LGS_TRACE("Size of queue " << Simulation::updateQueue.size());
+
+#ifdef LGS_TRACE_ENABLED
+
+#include <iostream>
+
+#define LGS_TRACE(message) do { std::clog << message << '\n'; } while (0)
+
+#else
+
+#define LGS_TRACE(message) do { } while (0)
+
+#endif
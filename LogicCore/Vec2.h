@@ -0,0 +1,14 @@
+#pragma once
+
+// Plain 2D vector used for gate positions, so the core does not depend on SFML.
+struct Vec2f {
+    float x, y;
+
+    Vec2f() : x(0), y(0) {}
+    Vec2f(float _x, float _y) : x(_x), y(_y) {}
+
+    Vec2f operator+(const Vec2f& o) const { return Vec2f(x + o.x, y + o.y); }
+    Vec2f operator-(const Vec2f& o) const { return Vec2f(x - o.x, y - o.y); }
+    Vec2f operator*(float s) const { return Vec2f(x * s, y * s); }
+    Vec2f operator/(float s) const { return Vec2f(x / s, y / s); }
+};
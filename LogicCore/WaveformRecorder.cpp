@@ -0,0 +1,215 @@
+#include "WaveformRecorder.h"
+
+// VCD identifiers are strings of the printable characters ! .. ~
+static std::string identifier(int index) {
+    std::string id;
+    do {
+        id += (char)('!' + index % 94);
+        index /= 94;
+    } while (index > 0);
+    return id;
+}
+
+WaveformRecorder::WaveformRecorder() {
+    stopping = false;
+    started = false;
+    lastTime = 0;
+}
+
+WaveformRecorder::~WaveformRecorder() {
+    close();
+}
+
+bool WaveformRecorder::open(const std::string& fileName, const std::string& _timescale) {
+    close();
+
+    names.clear();
+    initialValues.clear();
+    timescale = _timescale;
+
+    file.open(fileName, std::ofstream::out | std::ofstream::binary);
+    return file.is_open();
+}
+
+int WaveformRecorder::addSignal(const std::string& name, bool initialValue) {
+    names.push_back(name);
+    initialValues.push_back(initialValue);
+    return (int)names.size() - 1;
+}
+
+void WaveformRecorder::start() {
+    identifiers.clear();
+    for (size_t i = 0; i < names.size(); i++) {
+        identifiers.push_back(identifier((int)i));
+    }
+
+    file << "$timescale " << timescale << " $end\n";
+    file << "$scope module lgs $end\n";
+    for (size_t i = 0; i < names.size(); i++) {
+        file << "$var wire 1 " << identifiers[i] << ' ' << names[i] << " $end\n";
+    }
+    file << "$upscope $end\n";
+    file << "$enddefinitions $end\n";
+
+    file << "#0\n$dumpvars\n";
+    for (size_t i = 0; i < names.size(); i++) {
+        file << (initialValues[i] ? '1' : '0') << identifiers[i] << '\n';
+    }
+    file << "$end\n";
+
+    lastTime = 0;
+    stopping = false;
+    started = true;
+    current.reserve(WAVEFORM_BUFFER_CHANGES);
+    writer = std::thread(&WaveformRecorder::writerLoop, this);
+}
+
+void WaveformRecorder::handOff() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    // only wait when the writer is far behind, the simulation must not run out of memory either
+    wake.wait(lock, [this] { return pending.size() < WAVEFORM_MAX_PENDING; });
+
+    pending.push_back(std::move(current));
+
+    current.clear();
+    if (!spare.empty()) {
+        current.swap(spare.back());
+        spare.pop_back();
+    }
+    current.reserve(WAVEFORM_BUFFER_CHANGES);
+
+    wake.notify_all();
+}
+
+void WaveformRecorder::formatChanges(const std::vector<Change>& changes, std::string& text) {
+    for (const Change& c : changes) {
+        if (c.time != lastTime) {
+            lastTime = c.time;
+            text += '#';
+            text += std::to_string(c.time);
+            text += '\n';
+        }
+        text += c.value ? '1' : '0';
+        text += identifiers[c.signal];
+        text += '\n';
+    }
+}
+
+void WaveformRecorder::writerLoop() {
+    std::string text;
+
+    while (true) {
+        std::vector<Change> changes;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !pending.empty(); });
+
+            if (pending.empty()) { return; } // stopping, and everything is written
+
+            changes = std::move(pending.front());
+            pending.pop_front();
+            wake.notify_all();
+        }
+
+        text.clear();
+        formatChanges(changes, text);
+        file.write(text.data(), text.size());
+
+        changes.clear();
+        std::lock_guard<std::mutex> lock(mutex);
+        spare.push_back(std::move(changes));
+    }
+}
+
+void WaveformRecorder::close() {
+    if (started) {
+        if (!current.empty()) {
+            handOff();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        writer.join();
+
+        started = false;
+        spare.clear();
+    }
+
+    if (file.is_open()) {
+        file.close();
+    }
+}
+
+static const char* typeNames[] = { "or", "and", "not", "xor", "switch", "light", "chip" };
+
+std::vector<int> addNetlistSignals(WaveformRecorder& recorder, const Netlist& netlist, const std::vector<char>& netStates, bool allNets) {
+    std::vector<int> signals(netlist.gateCount(), -1);
+
+    for (size_t i = 0; i < netlist.primaryInputs.size(); i++) {
+        int net = netlist.primaryInputs[i];
+        signals[net] = recorder.addSignal("in" + std::to_string(i), netStates[net] != 0);
+    }
+    for (size_t i = 0; i < netlist.primaryOutputs.size(); i++) {
+        int net = netlist.primaryOutputs[i];
+        signals[net] = recorder.addSignal("out" + std::to_string(i), netStates[net] != 0);
+    }
+
+    if (allNets) {
+        for (int net = 0; net < netlist.gateCount(); net++) {
+            if (signals[net] != -1) { continue; }
+            std::string name = "n" + std::to_string(net) + "_" + typeNames[(int)netlist.types[net]];
+            signals[net] = recorder.addSignal(name, netStates[net] != 0);
+        }
+    }
+
+    return signals;
+}
+
+void addCircuitSignals(WaveformRecorder& recorder, std::vector<Gate*>& gates, bool allPins) {
+    int inputs = 0;
+    int outputs = 0;
+
+    for (size_t i = 0; i < gates.size(); i++) {
+        Gate* gate = gates[i];
+        GateType type = gate->getGateType();
+
+        if (type == GateType::SWITCH) {
+            Pin* pin = gate->getOutputPins();
+            pin->waveformSignal = recorder.addSignal("in" + std::to_string(inputs++), pin->cachedState);
+        }
+        else if (type == GateType::LIGHT) {
+            Pin* pin = gate->getInputPins();
+            pin->waveformSignal = recorder.addSignal("out" + std::to_string(outputs++), pin->cachedState);
+        }
+        else if (allPins) {
+            std::string name = typeNames[(int)type] + std::to_string(i);
+            int count = gate->getOutputPinCount();
+            Pin* pins = gate->getOutputPins();
+
+            for (int p = 0; p < count; p++) {
+                std::string pinName = count == 1 ? name : name + "_" + std::to_string(p);
+                pins[p].waveformSignal = recorder.addSignal(pinName, pins[p].cachedState);
+            }
+        }
+    }
+}
+
+void clearCircuitSignals(std::vector<Gate*>& gates) {
+    for (auto gate : gates) {
+        int count = gate->getInputPinCount();
+        Pin* pins = gate->getInputPins();
+        for (int p = 0; p < count; p++) {
+            pins[p].waveformSignal = -1;
+        }
+
+        count = gate->getOutputPinCount();
+        pins = gate->getOutputPins();
+        for (int p = 0; p < count; p++) {
+            pins[p].waveformSignal = -1;
+        }
+    }
+}
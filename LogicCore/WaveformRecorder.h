@@ -0,0 +1,99 @@
+#pragma once
+
+#include "Netlist.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define WAVEFORM_BUFFER_CHANGES (1 << 16) // changes per buffer handed to the writer thread
+#define WAVEFORM_MAX_PENDING 64           // full buffers queued before the simulation waits for the writer
+
+// Writes value changes of 1 bit signals to a VCD file, for GTKWave & co.
+// The simulation side only appends to a buffer; full buffers go to a background thread that formats
+// and writes them, so recording costs the simulation a push_back per change.
+//
+//   recorder.open("run.vcd");
+//   int clk = recorder.addSignal("clk", false);   // every signal before start
+//   recorder.start();
+//   recorder.change(time, clk, true);             // times never decrease
+//   recorder.close();
+class WaveformRecorder {
+private:
+    struct Change {
+        uint64_t time;
+        int signal;
+        bool value;
+    };
+
+    std::ofstream file;
+    std::string timescale;
+    std::vector<std::string> names;
+    std::vector<char> initialValues;
+    std::vector<std::string> identifiers; // VCD code of every signal
+
+    std::vector<Change> current;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::vector<Change>> pending;
+    std::vector<std::vector<Change>> spare;
+    std::thread writer;
+    bool stopping;
+    bool started;
+
+    uint64_t lastTime; // writer thread only
+
+    void handOff();
+    void writerLoop();
+    void formatChanges(const std::vector<Change>& changes, std::string& text);
+
+public:
+    WaveformRecorder();
+    ~WaveformRecorder();
+
+    // timescale is one simulation time unit, e.g. "1ns" (delta cycles and unit gate delays have no real unit)
+    bool open(const std::string& fileName, const std::string& _timescale = "1ns");
+
+    int addSignal(const std::string& name, bool initialValue);
+
+    // Writes the header and the initial values, starts the writer thread
+    void start();
+
+    void change(uint64_t time, int signal, bool value) {
+        current.push_back(Change{ time, signal, value });
+        if (current.size() >= WAVEFORM_BUFFER_CHANGES) {
+            handOff();
+        }
+    }
+
+    // Writes what is left and closes the file
+    void close();
+
+    // Between start and close
+    bool isRecording() {
+        return started;
+    }
+
+    int signalCount() {
+        return (int)names.size();
+    }
+};
+
+// Adds a signal per primary input (in0 ..) and output (out0 ..) of the netlist, or per net when allNets is
+// set (other nets are named after their index and gate type, n12_xor). Returns the signal of every net,
+// -1 for the ones not recorded, in the form EventSimulation::record and NetlistSimulation::record take.
+std::vector<int> addNetlistSignals(WaveformRecorder& recorder, const Netlist& netlist, const std::vector<char>& netStates, bool allNets);
+
+// Gives the pins of a gate object circuit signals : switch outputs (in0 ..) and light inputs (out0 ..) in
+// circuit order, plus every other gate's outputs when allPins is set (and3, chip7_1 ..).
+// Simulation::recorder must point at the recorder while it runs.
+void addCircuitSignals(WaveformRecorder& recorder, std::vector<Gate*>& gates, bool allPins);
+
+// Stops recording the pins of the circuit (waveformSignal back to -1)
+void clearCircuitSignals(std::vector<Gate*>& gates);
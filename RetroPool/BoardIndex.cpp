@@ -0,0 +1,135 @@
+#include "BoardIndex.h"
+
+#include <algorithm>
+#include <cmath>
+
+BoardIndex::BoardIndex() {
+    viewCount = 0;
+    queryCount = 0;
+}
+
+int BoardIndex::cellOf(float coordinate) {
+    return (int)std::floor(coordinate / BOARD_INDEX_CELL_SIZE);
+}
+
+void BoardIndex::insert(GateView* view) {
+    sf::FloatRect bounds = view->getBounds();
+    int left = cellOf(bounds.left);
+    int top = cellOf(bounds.top);
+    int right = cellOf(bounds.left + bounds.width);
+    int bottom = cellOf(bounds.top + bounds.height);
+
+    view->indexedCells = sf::IntRect(left, top, right - left + 1, bottom - top + 1);
+
+    for (int y = top; y <= bottom; y++) {
+        for (int x = left; x <= right; x++) {
+            cells[cellKey(x, y)].push_back(view);
+        }
+    }
+}
+
+void BoardIndex::remove(GateView* view) {
+    sf::IntRect area = view->indexedCells;
+
+    for (int y = area.top; y < area.top + area.height; y++) {
+        for (int x = area.left; x < area.left + area.width; x++) {
+            auto it = cells.find(cellKey(x, y));
+            if (it == cells.end()) { continue; }
+
+            std::vector<GateView*>& list = it->second;
+            list.erase(std::remove(list.begin(), list.end(), view), list.end());
+            if (list.empty()) {
+                cells.erase(it);
+            }
+        }
+    }
+}
+
+void BoardIndex::update(const std::vector<GateView*>& views) {
+    for (; viewCount < views.size(); viewCount++) {
+        views[viewCount]->id = (int)viewCount;
+        insert(views[viewCount]);
+    }
+    seen.resize(viewCount, 0);
+}
+
+void BoardIndex::move(GateView* view) {
+    remove(view);
+    insert(view);
+}
+
+void BoardIndex::clear() {
+    cells.clear();
+    found.clear();
+    seen.clear();
+    viewCount = 0;
+}
+
+const std::vector<GateView*>& BoardIndex::at(sf::Vector2f pos) {
+    found.clear();
+
+    auto it = cells.find(cellKey(cellOf(pos.x), cellOf(pos.y)));
+    if (it == cells.end()) {
+        return found;
+    }
+
+    for (auto view : it->second) {
+        if (view->getBounds().contains(pos)) {
+            found.push_back(view);
+        }
+    }
+
+    // a moved view goes to the back of its cells
+    std::sort(found.begin(), found.end(), [](GateView* a, GateView* b) {
+        return a->id < b->id;
+    });
+
+    return found;
+}
+
+const std::vector<GateView*>& BoardIndex::query(sf::FloatRect area) {
+    found.clear();
+    queryCount++;
+
+    int left = cellOf(area.left);
+    int top = cellOf(area.top);
+    int right = cellOf(area.left + area.width);
+    int bottom = cellOf(area.top + area.height);
+
+    // a view spanning several cells is met once per cell
+    auto collect = [&](const std::vector<GateView*>& list) {
+        for (auto view : list) {
+            if (seen[view->id] != queryCount) {
+                seen[view->id] = queryCount;
+                found.push_back(view);
+            }
+        }
+    };
+
+    if ((double)(right - left + 1) * (bottom - top + 1) <= (double)cells.size()) {
+        for (int y = top; y <= bottom; y++) {
+            for (int x = left; x <= right; x++) {
+                auto it = cells.find(cellKey(x, y));
+                if (it != cells.end()) {
+                    collect(it->second);
+                }
+            }
+        }
+    }
+    else {
+        // zoomed far out : fewer occupied cells than cells on screen
+        for (auto& entry : cells) {
+            int x = (int)(int32_t)(entry.first >> 32);
+            int y = (int)(int32_t)(uint32_t)entry.first;
+            if (x >= left && x <= right && y >= top && y <= bottom) {
+                collect(entry.second);
+            }
+        }
+    }
+
+    std::sort(found.begin(), found.end(), [](GateView* a, GateView* b) {
+        return a->id < b->id;
+    });
+
+    return found;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include "GateView.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#define BOARD_INDEX_CELL_SIZE 64 // about a gate, so a view is listed in a few cells
+
+// Uniform grid over the board for picking and culling : each view is listed in every cell its bounds (body and
+// pins) overlap, so finding what is under the mouse only looks at the views of one cell, however
+// many gates the board holds. Views are re-listed when they move (move), which only touches the
+// cells they leave and enter.
+class BoardIndex {
+private:
+    std::unordered_map<uint64_t, std::vector<GateView*>> cells;
+    size_t viewCount; // views already listed
+    std::vector<GateView*> found;
+    std::vector<unsigned int> seen; // by view id, query number of the last query that returned it
+    unsigned int queryCount;
+
+    static uint64_t cellKey(int x, int y) {
+        return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+    }
+
+    static int cellOf(float coordinate);
+
+    void insert(GateView* view);
+    void remove(GateView* view);
+
+public:
+    BoardIndex();
+
+    // Lists the views appended since the last call. views only grows, call clear when the views are deleted.
+    void update(const std::vector<GateView*>& views);
+
+    // After view->position
+    void move(GateView* view);
+
+    void clear();
+
+    // Views whose bounds contain pos, in the order they were created (the order of the views vector)
+    const std::vector<GateView*>& at(sf::Vector2f pos);
+
+    // Views whose cells overlap area (a few may be just outside it), in creation order. Costs the
+    // cells of the area or the occupied cells, whichever is fewer, plus the views found.
+    const std::vector<GateView*>& query(sf::FloatRect area);
+};
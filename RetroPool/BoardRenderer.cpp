@@ -0,0 +1,232 @@
+#include "BoardRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+static void writeQuad(sf::Vertex* v, sf::FloatRect rect, sf::Color color, sf::FloatRect texture = sf::FloatRect()) {
+    float right = rect.left + rect.width;
+    float bottom = rect.top + rect.height;
+    float u2 = texture.left + texture.width;
+    float v2 = texture.top + texture.height;
+
+    v[0] = sf::Vertex(sf::Vector2f(rect.left, rect.top), color, sf::Vector2f(texture.left, texture.top));
+    v[1] = sf::Vertex(sf::Vector2f(right, rect.top), color, sf::Vector2f(u2, texture.top));
+    v[2] = sf::Vertex(sf::Vector2f(rect.left, bottom), color, sf::Vector2f(texture.left, v2));
+    v[3] = v[2];
+    v[4] = v[1];
+    v[5] = sf::Vertex(sf::Vector2f(right, bottom), color, sf::Vector2f(u2, v2));
+}
+
+// One quad per character, laid out like sf::Text without styles (spaces get an empty quad)
+static void writeGlyphs(sf::Vertex* v, const sf::String& string, unsigned int size, sf::Vector2f origin) {
+    const float padding = 1.0f; // same as sf::Text, so the glyph edges are not cut
+
+    float x = 0;
+    float y = (float)size;
+    sf::Uint32 previous = 0;
+
+    for (size_t i = 0; i < string.getSize(); i++) {
+        sf::Uint32 current = string[i];
+
+        x += font.getKerning(previous, current, size);
+        previous = current;
+
+        const sf::Glyph& glyph = font.getGlyph(current, size, false);
+        sf::FloatRect bounds(origin.x + x + glyph.bounds.left - padding, origin.y + y + glyph.bounds.top - padding,
+            glyph.bounds.width + 2 * padding, glyph.bounds.height + 2 * padding);
+        sf::FloatRect texture((float)glyph.textureRect.left - padding, (float)glyph.textureRect.top - padding,
+            (float)glyph.textureRect.width + 2 * padding, (float)glyph.textureRect.height + 2 * padding);
+
+        if (glyph.bounds.width == 0) {
+            bounds = sf::FloatRect();
+        }
+        writeQuad(v + i * RECT_VERTICES, bounds, sf::Color::White, texture);
+
+        x += glyph.advance;
+    }
+}
+
+// Liang-Barsky : whether the segment a-b has a point inside rect
+static bool segmentCrosses(sf::Vector2f a, sf::Vector2f b, sf::FloatRect rect) {
+    float d[2] = { b.x - a.x, b.y - a.y };
+    float low[2] = { rect.left - a.x, rect.top - a.y };
+    float high[2] = { rect.left + rect.width - a.x, rect.top + rect.height - a.y };
+    float enter = 0.0f, leave = 1.0f;
+
+    for (int axis = 0; axis < 2; axis++) {
+        if (d[axis] == 0.0f) {
+            if (low[axis] > 0.0f || high[axis] < 0.0f) { return false; }
+            continue;
+        }
+
+        float t0 = low[axis] / d[axis];
+        float t1 = high[axis] / d[axis];
+        if (t0 > t1) { std::swap(t0, t1); }
+
+        enter = std::max(enter, t0);
+        leave = std::min(leave, t1);
+        if (enter > leave) { return false; }
+    }
+
+    return true;
+}
+
+BoardRenderer::BoardRenderer() {
+    shapes.setPrimitiveType(sf::Triangles);
+    frameShapes.setPrimitiveType(sf::Triangles);
+    wires.setPrimitiveType(sf::Lines);
+    wiresChanged = false;
+    viewCount = 0;
+}
+
+void BoardRenderer::place(GateView* view) {
+    view->firstShapeVertex = shapes.getVertexCount();
+    shapes.resize(shapes.getVertexCount() + view->getShapeCount() * RECT_VERTICES);
+
+    sf::VertexArray& glyphs = labels[view->getLabelSize()];
+    glyphs.setPrimitiveType(sf::Triangles);
+    view->firstGlyphVertex = glyphs.getVertexCount();
+    glyphs.resize(glyphs.getVertexCount() + view->getLabel().getSize() * RECT_VERTICES);
+
+    view->dirty = true;
+}
+
+void BoardRenderer::write(GateView* view) {
+    for (int i = 0; i < view->getShapeCount(); i++) {
+        writeQuad(&shapes[view->firstShapeVertex + i * RECT_VERTICES], view->getShapeBounds(i), view->getShapeColor(i));
+    }
+
+    writeGlyphs(&labels[view->getLabelSize()][view->firstGlyphVertex], view->getLabel(), view->getLabelSize(), view->getLabelPosition());
+
+    view->dirty = false;
+}
+
+void BoardRenderer::update(const std::vector<GateView*>& views) {
+    if (viewCount < views.size()) {
+        wiresChanged = true;
+    }
+    for (; viewCount < views.size(); viewCount++) {
+        place(views[viewCount]);
+    }
+
+    if (!wiresChanged) { return; }
+
+    longWires.clear();
+    for (auto view : views) {
+        Gate* gate = view->gate;
+        Pin* inputPins = gate->getInputPins();
+        for (int i = 0; i < gate->getInputPinCount(); i++) {
+            if (inputPins[i].connectedTo == nullptr) { continue; }
+
+            sf::Vector2f span = getPinPosition(inputPins + i) - getPinPosition(inputPins[i].connectedTo);
+            if (std::abs(span.x) > WIRE_MARGIN || std::abs(span.y) > WIRE_MARGIN) {
+                longWires.push_back(inputPins + i);
+            }
+        }
+    }
+    wiresChanged = false;
+}
+
+void BoardRenderer::clear() {
+    shapes.clear();
+    labels.clear();
+    frameShapes.clear();
+    wires.clear();
+    frameLabels.clear();
+    nearGates.clear();
+    longWires.clear();
+    wiresChanged = false;
+    viewCount = 0;
+}
+
+void BoardRenderer::addWire(Pin* output, Pin* input, sf::FloatRect area) {
+    sf::Vector2f from = getPinPosition(output);
+    sf::Vector2f to = getPinPosition(input);
+    if (!segmentCrosses(from, to, area)) { return; }
+
+    wires.append(sf::Vertex(from, WIRE_COLOR));
+    wires.append(sf::Vertex(to, WIRE_COLOR));
+}
+
+void BoardRenderer::draw(sf::RenderTarget& target, BoardIndex& index, sf::FloatRect area, bool lowDetail) {
+    frameShapes.clear();
+    wires.clear();
+    for (auto& entry : frameLabels) {
+        entry.second.clear();
+    }
+    nearGates.clear();
+
+    for (auto view : index.query(area)) {
+        // views off screen are written when they come into view
+        if (view->dirty) {
+            write(view);
+        }
+
+        size_t first = frameShapes.getVertexCount();
+        int count = lowDetail ? RECT_VERTICES : view->getShapeCount() * RECT_VERTICES;
+        for (int i = 0; i < count; i++) {
+            frameShapes.append(shapes[view->firstShapeVertex + i]);
+        }
+
+        if (lowDetail) { continue; }
+
+        // the indicator is the view's second rectangle
+        if (view->hasIndicator()) {
+            sf::Color color = view->getIndicatorColor();
+            for (int i = 0; i < RECT_VERTICES; i++) {
+                frameShapes[first + RECT_VERTICES + i].color = color;
+            }
+        }
+
+        sf::VertexArray& glyphs = labels[view->getLabelSize()];
+        sf::VertexArray& frameGlyphs = frameLabels[view->getLabelSize()];
+        frameGlyphs.setPrimitiveType(sf::Triangles);
+        for (size_t i = 0; i < view->getLabel().getSize() * RECT_VERTICES; i++) {
+            frameGlyphs.append(glyphs[view->firstGlyphVertex + i]);
+        }
+    }
+
+    sf::FloatRect near(area.left - WIRE_MARGIN, area.top - WIRE_MARGIN, area.width + 2 * WIRE_MARGIN, area.height + 2 * WIRE_MARGIN);
+    const std::vector<GateView*>& nearViews = index.query(near);
+    for (auto view : nearViews) {
+        nearGates.insert(view->gate);
+    }
+
+    // each wire once : by its input pin, or by its output pin when the input's gate is not near
+    for (auto view : nearViews) {
+        Gate* gate = view->gate;
+
+        Pin* inputPins = gate->getInputPins();
+        for (int i = 0; i < gate->getInputPinCount(); i++) {
+            if (inputPins[i].connectedTo != nullptr) {
+                addWire(inputPins[i].connectedTo, inputPins + i, area);
+            }
+        }
+
+        Pin* outputPins = gate->getOutputPins();
+        for (int i = 0; i < gate->getOutputPinCount(); i++) {
+            for (auto other : outputPins[i].getFanout()) {
+                if (nearGates.count(other->parentGate) == 0) {
+                    addWire(outputPins + i, other, area);
+                }
+            }
+        }
+    }
+
+    // both ends far from the screen
+    for (auto input : longWires) {
+        if (input->connectedTo != nullptr && nearGates.count(input->parentGate) == 0 && nearGates.count(input->connectedTo->parentGate) == 0) {
+            addWire(input->connectedTo, input, area);
+        }
+    }
+
+    target.draw(frameShapes);
+    target.draw(wires);
+
+    if (lowDetail) { return; }
+
+    for (auto& entry : frameLabels) {
+        target.draw(entry.second, sf::RenderStates(&font.getTexture(entry.first)));
+    }
+}
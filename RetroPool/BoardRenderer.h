@@ -0,0 +1,68 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include "BoardIndex.h"
+#include "GateView.h"
+
+#include <map>
+#include <unordered_set>
+#include <vector>
+
+#define RECT_VERTICES 6 // two triangles
+
+#define WIRE_COLOR sf::Color(3, 127, 252)
+#define WIRE_MARGIN 1024.0f // board units, wires spanning more are kept in the long wire list
+
+// Draws the board in a handful of draw calls instead of several per gate : one vertex array for
+// the bodies, indicators and pins, one for the wires, and one per label character size holding the
+// glyphs (each size has its own font texture).
+//
+// Every view's vertices are kept in cache arrays, at the same place for the view's lifetime, and only
+// written again when the view is marked dirty (moved, pin highlighted). Each frame the vertices of
+// the views on screen are copied into the arrays that are drawn, so a frame costs what is visible,
+// not the size of the board. Switch and light indicators are recoloured as they are copied.
+//
+// Wires are rebuilt every frame and drawn when their segment crosses the screen. The ones with an
+// end near the screen come from the views found within WIRE_MARGIN of it. A wire crossing the screen
+// with both ends further away spans more than WIRE_MARGIN, so it is in the long wire list, which is
+// only rebuilt after an edit (invalidateWires) and is short on any sensible layout. A gate being
+// dragged is under the mouse, so its wires always have an end near the screen.
+//
+// With lowDetail (zoomed out) a view is only its body, without label or pins.
+class BoardRenderer {
+private:
+    sf::VertexArray shapes;
+    std::map<unsigned int, sf::VertexArray> labels;
+
+    sf::VertexArray frameShapes;
+    sf::VertexArray wires;
+    std::map<unsigned int, sf::VertexArray> frameLabels;
+    std::unordered_set<Gate*> nearGates; // of the views within WIRE_MARGIN of the screen
+
+    std::vector<Pin*> longWires; // by input pin
+    bool wiresChanged;
+
+    size_t viewCount; // views already given a place
+
+    void place(GateView* view);
+    void write(GateView* view);
+    void addWire(Pin* output, Pin* input, sf::FloatRect area);
+
+public:
+    BoardRenderer();
+
+    // Places the views appended since the last call. views only grows, call clear when the views are deleted.
+    // Rebuilds the long wire list when views were appended or invalidateWires was called.
+    void update(const std::vector<GateView*>& views);
+
+    // After connections are made or removed, or a gate is dropped somewhere else
+    void invalidateWires() {
+        wiresChanged = true;
+    }
+
+    void clear();
+
+    // Draws what is in area (the part of the board on screen), the views found through index
+    void draw(sf::RenderTarget& target, BoardIndex& index, sf::FloatRect area, bool lowDetail);
+};
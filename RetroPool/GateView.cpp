@@ -0,0 +1,325 @@
+#include "GateView.h"
+#include "IntegratedChip.h"
+#include "Trace.h"
+
+#include <algorithm>
+
+sf::Font font;
+GatePool boardPool;
+TopologicalOrder boardOrder;
+
+Pin* hoveredPin = nullptr;
+GateView* hoveredView = nullptr;
+
+PinHandle firstPinSelected;
+
+sf::Vector2f toSf(Vec2f v) {
+    return sf::Vector2f(v.x, v.y);
+}
+
+Vec2f fromSf(sf::Vector2f v) {
+    return Vec2f(v.x, v.y);
+}
+
+sf::Vector2f getBodySize(Gate* gate) {
+    sf::Vector2f bodySize(50, 50);
+
+    if (gate->getGateType() == GateType::INTEGRATED) {
+        bodySize.x += PIN_SIZE * gate->getInputPinCount(); // TODO : make this better
+    }
+
+    return bodySize;
+}
+
+sf::Vector2f getPinOffset(Gate* gate, PinType pt, int index) {
+    switch (gate->getGateType()) {
+        case GateType::OR:
+        case GateType::AND:
+        case GateType::XOR:
+            if (pt == PinType::Output) {
+                return sf::Vector2f(0, -25 - 5);
+            }
+            return index == 0 ? sf::Vector2f(-25 + 5, 25 + 5) : sf::Vector2f(+25 - 5, 25 + 5);
+        case GateType::NOT:
+        case GateType::SWITCH:
+        case GateType::LIGHT:
+            return pt == PinType::Output ? sf::Vector2f(0, -25 - 5) : sf::Vector2f(0, 25 + 5);
+        case GateType::INTEGRATED: {
+            sf::Vector2f bodySize = getBodySize(gate);
+            if (pt == PinType::Input) {
+                int count = gate->getInputPinCount();
+                return sf::Vector2f((index - count / 2.0f) * PIN_SIZE * 2.0f + PIN_SIZE, bodySize.y / 2.0f + PIN_SIZE / 2.0f);
+            }
+            int count = gate->getOutputPinCount();
+            return sf::Vector2f((index - count / 2.0f) * PIN_SIZE * 2.0f + PIN_SIZE, -(bodySize.y / 2.0f + PIN_SIZE / 2.0f));
+        }
+    }
+
+    return sf::Vector2f(0, 0);
+}
+
+sf::Vector2f getPinPosition(Pin* pin) {
+    Gate* gate = pin->parentGate;
+
+    int index = 0;
+    gate->getPinIndex(pin, pin->pinType, index);
+
+    return toSf(gate->getPosition()) + getPinOffset(gate, pin->pinType, index);
+}
+
+void onPinClicked(Pin * pin) {
+    Pin* first = boardPool.get(firstPinSelected);
+    if (first == nullptr) {
+        firstPinSelected = boardPool.handleOf(pin);
+    }
+    else {
+        // both pins selected ...
+        LGS_TRACE("Both pins selected");
+
+        if (
+            (first->pinType == PinType::Input && pin->pinType == PinType::Output) ||
+            (first->pinType == PinType::Output && pin->pinType == PinType::Input)
+            ) {
+            Pin* input = pin->pinType == PinType::Input ? pin : first;
+            Pin* output = pin->pinType == PinType::Input ? first : pin;
+            Pin* previous = input->connectedTo; // replaced by connectPins
+
+            Pin::connectPins(first, pin);
+
+            if (previous != nullptr) {
+                boardOrder.disconnect(previous, input);
+            }
+            boardOrder.connect(output, input); // a loop shows in the title bar
+        }
+
+
+        firstPinSelected = PinHandle();
+    }
+}
+
+void onPinRightClicked(Pin* pin) {
+    if (pin->pinType == PinType::Input) {
+        if (pin->connectedTo != nullptr) {
+            boardOrder.disconnect(pin->connectedTo, pin);
+        }
+    }
+    else {
+        for (Pin* other : pin->getFanout()) {
+            boardOrder.disconnect(pin, other);
+        }
+    }
+
+    pin->disconnectAll();
+}
+
+void drawTempConnection(sf::RenderTarget& target, sf::Vector2f mousePos) {
+    Pin* first = boardPool.get(firstPinSelected);
+    if (first == nullptr) { return; }
+
+    sf::Vertex line[2];
+    line[0].position = getPinPosition(first);
+    line[0].color = sf::Color(255,127,0);
+    line[1].position = mousePos;
+    line[1].color = sf::Color(255, 127, 0);
+
+    target.draw(line, 2, sf::Lines);
+}
+
+void setHoveredPin(GateView* view, Pin* pin) {
+    if (pin == hoveredPin) { return; }
+
+    if (hoveredView != nullptr) {
+        hoveredView->setPinHovered(hoveredPin, false);
+    }
+    if (view != nullptr) {
+        view->setPinHovered(pin, true);
+    }
+
+    hoveredPin = pin;
+    hoveredView = view;
+}
+
+GateView::GateView(Gate* _gate) {
+    gate = _gate;
+    firstShapeVertex = 0;
+    firstGlyphVertex = 0;
+    dirty = true;
+    id = -1;
+    hoveredShape = -1;
+
+    bodySize = getBodySize(gate);
+    labelSize = 30; // sf::Text default
+
+    switch (gate->getGateType()) {
+        case GateType::OR:
+            label = "OR";
+            break;
+        case GateType::AND:
+            label = "AND";
+            break;
+        case GateType::NOT:
+            label = "NOT";
+            break;
+        case GateType::XOR:
+            label = "XOR";
+            break;
+        case GateType::SWITCH:
+            label = "Switch";
+            labelSize = 12;
+            break;
+        case GateType::LIGHT:
+            label = "Light";
+            labelSize = 12;
+            break;
+        case GateType::INTEGRATED:
+            label = static_cast<IntegratedChip*>(gate)->name;
+            break;
+    }
+
+    // measured once, the label never changes
+    sf::FloatRect textRect = sf::Text(label, font, labelSize).getGlobalBounds();
+    labelOffset = -sf::Vector2f(textRect.width, textRect.height) / 2.0f;
+
+    position(toSf(gate->getPosition()));
+}
+
+int GateView::getPinShapeIndex(Pin* pin) {
+    int index = (int)(pin - gate->getInputPins());
+    if (index >= 0 && index < gate->getInputPinCount()) {
+        return 2 + index;
+    }
+
+    index = (int)(pin - gate->getOutputPins());
+    if (index >= 0 && index < gate->getOutputPinCount()) {
+        return 2 + gate->getInputPinCount() + index;
+    }
+
+    return -1;
+}
+
+Pin* GateView::pinAt(sf::Vector2f pos) {
+    int inputs = gate->getInputPinCount();
+    for (int i = 0; i < inputs; i++) {
+        if (getShapeBounds(2 + i).contains(pos)) {
+            return gate->getInputPins() + i;
+        }
+    }
+    for (int i = 0; i < gate->getOutputPinCount(); i++) {
+        if (getShapeBounds(2 + inputs + i).contains(pos)) {
+            return gate->getOutputPins() + i;
+        }
+    }
+
+    return nullptr;
+}
+
+bool GateView::tryClick(sf::Vector2f pos) {
+    Pin* pin = pinAt(pos);
+    if (pin != nullptr) {
+        onPinClicked(pin);
+    }
+    return pin != nullptr;
+}
+
+bool GateView::tryRightClick(sf::Vector2f pos) {
+    Pin* pin = pinAt(pos);
+    if (pin != nullptr) {
+        onPinRightClicked(pin);
+    }
+    return pin != nullptr;
+}
+
+void GateView::setPinHovered(Pin* pin, bool hovered) {
+    int index = getPinShapeIndex(pin);
+    if (index == -1) { return; }
+
+    if (hovered) {
+        hoveredShape = index;
+    }
+    else if (hoveredShape == index) {
+        hoveredShape = -1;
+    }
+    dirty = true;
+}
+
+void GateView::position(sf::Vector2f pos) {
+    gate->position(fromSf(pos));
+    center = pos;
+
+    bounds = getShapeBounds(0);
+    float right = bounds.left + bounds.width;
+    float bottom = bounds.top + bounds.height;
+
+    for (int i = 2; i < getShapeCount(); i++) {
+        sf::FloatRect pin = getShapeBounds(i);
+        bounds.left = std::min(bounds.left, pin.left);
+        bounds.top = std::min(bounds.top, pin.top);
+        right = std::max(right, pin.left + pin.width);
+        bottom = std::max(bottom, pin.top + pin.height);
+    }
+
+    bounds.width = right - bounds.left;
+    bounds.height = bottom - bounds.top;
+
+    dirty = true;
+}
+
+sf::Vector2f GateView::getPosition() {
+    return center;
+}
+
+bool GateView::isInBounds(float x, float y) {
+    return getShapeBounds(0).contains(sf::Vector2f(x, y));
+}
+
+bool GateView::hasIndicator() {
+    GateType type = gate->getGateType();
+    return type == GateType::SWITCH || type == GateType::LIGHT;
+}
+
+sf::Color GateView::getIndicatorColor() {
+    bool on = false;
+    if (gate->getGateType() == GateType::SWITCH) {
+        on = static_cast<Switch*>(gate)->getState();
+    }
+    else if (gate->getGateType() == GateType::LIGHT) {
+        on = static_cast<Light*>(gate)->getState();
+    }
+    return on ? sf::Color::Green : sf::Color::Red;
+}
+
+sf::FloatRect GateView::getShapeBounds(int index) {
+    if (index == 0) {
+        return sf::FloatRect(center - bodySize / 2.0f, bodySize);
+    }
+    if (index == 1) {
+        if (!hasIndicator()) {
+            return sf::FloatRect(center, sf::Vector2f(0, 0));
+        }
+        return sf::FloatRect(center.x - 2.5f, center.y - 2.5f - 10.f, 5, 5);
+    }
+
+    index -= 2;
+    int inputs = gate->getInputPinCount();
+    sf::Vector2f offset = index < inputs ?
+        getPinOffset(gate, PinType::Input, index) :
+        getPinOffset(gate, PinType::Output, index - inputs);
+
+    return sf::FloatRect(center + offset - sf::Vector2f(PIN_SIZE, PIN_SIZE) / 2.0f, sf::Vector2f(PIN_SIZE, PIN_SIZE));
+}
+
+sf::Color GateView::getShapeColor(int index) {
+    if (index == 0) {
+        return sf::Color(64, 64, 64);
+    }
+    if (index == 1) {
+        return getIndicatorColor();
+    }
+    return index == hoveredShape ? PIN_HOVER_COLOR : PIN_COLOR;
+}
+
+void syncViews(const std::vector<Gate*>& gates, std::vector<GateView*>& views) {
+    for (size_t i = views.size(); i < gates.size(); i++) {
+        views.push_back(new GateView(gates[i]));
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include "Gate.h"
+#include "GatePool.h"
+#include "TopologicalOrder.h"
+
+#include <vector>
+
+#define PIN_SIZE 10
+#define PIN_COLOR sf::Color(200, 250, 200)
+#define PIN_HOVER_COLOR sf::Color::Green
+
+extern sf::Font font;
+extern GatePool boardPool; // the gates on the board
+extern TopologicalOrder boardOrder; // their order and levels, kept up to date by the pin clicks
+
+class GateView;
+
+extern Pin* hoveredPin;
+extern GateView* hoveredView; // the view of hoveredPin
+extern PinHandle firstPinSelected; // a handle, so it cannot outlive its gate (Ctrl+N)
+
+sf::Vector2f toSf(Vec2f v);
+Vec2f fromSf(sf::Vector2f v);
+
+// Pin placement relative to the gate center. Pure function of the gate, so any pin's board
+// position can be recovered from the logical model alone (used for drawing wires).
+sf::Vector2f getBodySize(Gate* gate);
+sf::Vector2f getPinOffset(Gate* gate, PinType pt, int index);
+sf::Vector2f getPinPosition(Pin* pin);
+
+void onPinClicked(Pin* pin);
+void onPinRightClicked(Pin* pin);
+void drawTempConnection(sf::RenderTarget& target, sf::Vector2f mousePos);
+
+// Highlights pin (of view) instead of the pin highlighted so far, only those two pins are recoloured.
+// nullptr for both clears the highlight.
+void setHoveredPin(GateView* view, Pin* pin);
+
+// What the board shows of a gate : body, label, switch/light indicator and pins. The logical gate it
+// shows is owned by the circuit, not by the view.
+//
+// A view only keeps what it cannot recompute : its position, label and which pin is highlighted.
+// Pin and indicator rectangles are derived from the gate (getPinOffset), so a view costs about a
+// cache line or two instead of an sf::RectangleShape per pin, and the simulator never touches it.
+// Only the renderer and the mouse handling read views; BoardRenderer turns them into vertices.
+class GateView {
+private:
+    sf::Vector2f center;
+    sf::Vector2f bodySize;
+    sf::FloatRect bounds; // body and pins, updated by position
+
+    sf::String label;
+    unsigned int labelSize; // character size
+    sf::Vector2f labelOffset; // top left of the label from the center
+
+    int hoveredShape; // shape index of the highlighted pin, -1 for none
+
+    int getPinShapeIndex(Pin* pin);
+
+public:
+    Gate* gate;
+
+    // Kept by BoardRenderer : where the view's vertices are, and whether they must be written again
+    size_t firstShapeVertex;
+    size_t firstGlyphVertex;
+    bool dirty;
+
+    // Kept by BoardIndex : creation order, and the grid cells the view is listed in
+    int id;
+    sf::IntRect indexedCells;
+
+    GateView(Gate* _gate);
+
+    bool tryClick(sf::Vector2f pos);
+    bool tryRightClick(sf::Vector2f pos);
+    Pin* pinAt(sf::Vector2f pos);
+    void setPinHovered(Pin* pin, bool hovered);
+    void position(sf::Vector2f pos);
+    sf::Vector2f getPosition();
+    bool isInBounds(float x, float y);
+
+    // Body and pins
+    sf::FloatRect getBounds() {
+        return bounds;
+    }
+
+    bool hasIndicator();
+    sf::Color getIndicatorColor();
+
+    // Body, indicator (empty for gates without one) then input and output pins
+    int getShapeCount() {
+        return 2 + gate->getInputPinCount() + gate->getOutputPinCount();
+    }
+
+    sf::FloatRect getShapeBounds(int index);
+    sf::Color getShapeColor(int index);
+
+    const sf::String& getLabel() {
+        return label;
+    }
+
+    unsigned int getLabelSize() {
+        return labelSize;
+    }
+
+    sf::Vector2f getLabelPosition() {
+        return center + labelOffset;
+    }
+};
+
+// Creates views for gates appended to the circuit since the last call (after a load, for example).
+void syncViews(const std::vector<Gate*>& gates, std::vector<GateView*>& views);
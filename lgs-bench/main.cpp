@@ -0,0 +1,583 @@
+// lgs-bench : headless benchmarks for the logic core.
+//
+//   lgs-bench [--min-time seconds] [--bits n] [--filter text] [sample-dir]
+//
+// Runs every engine on the sample circuits found in sample-dir (default ., run it from RetroPool)
+// and on two synthetic circuits made by CircuitGenerator (a --bits bit ripple adder and a random DAG of
+// --bits * 8 gates), then prints one CSV row per benchmark to stdout :
+//
+//   benchmark,circuit,gates,iterations,seconds,events_per_s,evaluations_per_s,us_per_iteration,bytes_per_gate
+//
+// An iteration is one input vector (one load for the load benchmark, one open of the binary save plus
+// compileNetlist for open-binary, one pass of 512 patterns for pattern512 and native512). Empty fields do not apply to that engine. bytes_per_gate is the heap memory the loaded
+// circuit or the engine holds, divided by its gate count, measured by the counting operator new below.
+// --filter only runs benchmarks whose "benchmark/circuit" name contains the text.
+
+#include "BinaryFormat.h"
+#include "ChipDefinition.h"
+#include "CircuitGenerator.h"
+#include "EventScheduler.h"
+#include "Gate.h"
+#include "IntegratedChip.h"
+#include "LevelizedSimulation.h"
+#include "Metrics.h"
+#include "NativeSimulation.h"
+#include "Netlist.h"
+#include "PatternSimulation.h"
+#include "Serialization.h"
+#include "Simulation.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define DEFAULT_MIN_TIME 0.5
+#define DEFAULT_SYNTHETIC_BITS 1024
+#define VECTOR_COUNT 64
+#define MAX_SETTLE_TICKS 100000
+#define BINARY_BENCH_FILE "lgs-bench.lgsb" // scratch file of the open-binary benchmark, in the working directory
+
+// Live heap bytes, for memory per gate. Every allocation carries its size in front of it.
+static std::atomic<size_t> liveBytes(0);
+
+void* operator new(size_t size) {
+    char* block = (char*)std::malloc(size + sizeof(std::max_align_t));
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    *(size_t*)block = size;
+    liveBytes += size;
+    return block + sizeof(std::max_align_t);
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr == nullptr) { return; }
+
+    char* block = (char*)ptr - sizeof(std::max_align_t);
+    liveBytes -= *(size_t*)block;
+    std::free(block);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+struct BenchResult {
+    std::string benchmark;
+    std::string circuit;
+    long long gates = 0;
+    long long iterations = 0;
+    double seconds = 0.0;
+    double events = -1.0;      // totals over the measured iterations, -1 when the engine has no such counter
+    double evaluations = -1.0;
+    double bytes = -1.0;
+};
+
+struct BenchCircuit {
+    std::string name;
+    std::string text;   // save file contents
+    bool recursive;
+};
+
+static double minTime = DEFAULT_MIN_TIME;
+static std::string filter;
+
+static bool selected(const std::string& benchmark, const std::string& circuit) {
+    return filter.empty() || (benchmark + "/" + circuit).find(filter) != std::string::npos;
+}
+
+static void printHeader() {
+    std::cout << "benchmark,circuit,gates,iterations,seconds,events_per_s,evaluations_per_s,us_per_iteration,bytes_per_gate" << std::endl;
+}
+
+static void printResult(const BenchResult& r) {
+    std::cout << r.benchmark << ',' << r.circuit << ',' << r.gates << ',' << r.iterations << ',' << r.seconds << ',';
+    if (r.events >= 0) {
+        std::cout << r.events / r.seconds;
+    }
+    std::cout << ',';
+    if (r.evaluations >= 0) {
+        std::cout << r.evaluations / r.seconds;
+    }
+    std::cout << ',' << r.seconds * 1e6 / r.iterations << ',';
+    if (r.bytes >= 0 && r.gates > 0) {
+        std::cout << r.bytes / r.gates;
+    }
+    std::cout << std::endl;
+}
+
+// Calls body(n) with n = 1, 2, 4 ... until one call takes minTime, and keeps that call's numbers.
+// body fills in the counters of the result itself.
+template<typename Body>
+static void measure(BenchResult& r, Body body) {
+    for (long long n = 1; ; n *= 2) {
+        auto start = std::chrono::steady_clock::now();
+        body(n);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (seconds >= minTime || n >= (1ll << 40)) {
+            r.iterations = n;
+            r.seconds = seconds;
+            return;
+        }
+    }
+}
+
+static void loadCircuit(const BenchCircuit& circuit, std::vector<Gate*>& gates) {
+    std::istringstream iss(circuit.text);
+
+    if (circuit.recursive) {
+        loadFromFileRecursively(gates, iss);
+    }
+    else {
+        loadFromFile(gates, iss);
+    }
+}
+
+static void collectDefinitions(std::vector<Gate*>& gates, std::set<ChipDefinition*>& definitions) {
+    for (auto gate : gates) {
+        IntegratedChip* ic = dynamic_cast<IntegratedChip*>(gate);
+        if (ic != nullptr && definitions.insert(ic->definition).second) {
+            collectDefinitions(*ic->definition->getCircuit(), definitions);
+        }
+    }
+}
+
+// Gate objects in the circuit, counting each chip definition's circuit once
+static long long countGates(std::vector<Gate*>& gates) {
+    std::set<ChipDefinition*> definitions;
+    collectDefinitions(gates, definitions);
+
+    long long count = (long long)gates.size();
+    for (auto definition : definitions) {
+        count += (long long)definition->getCircuit()->size();
+    }
+    return count;
+}
+
+// Deletes the gates and the chip definitions the load created (nothing else owns them)
+static void freeCircuit(std::vector<Gate*>& gates) {
+    std::set<ChipDefinition*> definitions;
+    collectDefinitions(gates, definitions);
+
+    for (auto gate : gates) {
+        delete gate;
+    }
+    gates.clear();
+
+    for (auto definition : definitions) {
+        for (auto gate : *definition->getCircuit()) {
+            delete gate;
+        }
+        delete definition->getCircuit();
+        delete definition;
+    }
+}
+
+static std::vector<std::vector<bool>> randomVectors(size_t inputCount) {
+    std::mt19937 rng(1);
+    std::vector<std::vector<bool>> vectors(VECTOR_COUNT);
+
+    for (auto& vec : vectors) {
+        for (size_t i = 0; i < inputCount; i++) {
+            vec.push_back((rng() & 1) != 0);
+        }
+    }
+
+    return vectors;
+}
+
+static void benchLoad(const BenchCircuit& circuit) {
+    if (!selected("load", circuit.name)) { return; }
+
+    BenchResult r;
+    r.benchmark = "load";
+    r.circuit = circuit.name;
+
+    // the loaded gates are thrown away, keep their power-on events out of the global queue
+    Simulation::suspend();
+
+    std::vector<Gate*> gates;
+    size_t before = liveBytes;
+    loadCircuit(circuit, gates);
+    r.bytes = (double)(liveBytes - before);
+    r.gates = countGates(gates);
+    freeCircuit(gates);
+
+    measure(r, [&](long long n) {
+        for (long long i = 0; i < n; i++) {
+            loadCircuit(circuit, gates);
+            freeCircuit(gates);
+        }
+    });
+
+    Simulation::resume();
+
+    printResult(r);
+}
+
+// The circuit is saved to BINARY_BENCH_FILE once, then mapped and compiled to a netlist in every iteration
+static void benchOpenBinary(const std::string& circuitName, std::vector<Gate*>& gates) {
+    if (!selected("open-binary", circuitName)) { return; }
+
+    std::ofstream ofs(BINARY_BENCH_FILE, std::ofstream::out | std::ofstream::binary);
+    saveToBinary(gates, ofs);
+    ofs.close();
+    if (!ofs) {
+        std::cerr << "cannot write " << BINARY_BENCH_FILE << ", open-binary skipped" << std::endl;
+        return;
+    }
+
+    BenchResult r;
+    r.benchmark = "open-binary";
+    r.circuit = circuitName;
+    r.gates = countGates(gates);
+
+    measure(r, [&](long long n) {
+        for (long long i = 0; i < n; i++) {
+            BinaryCircuitFile file;
+            file.open(BINARY_BENCH_FILE);
+            Netlist netlist = compileNetlist(file);
+        }
+    });
+
+    std::remove(BINARY_BENCH_FILE);
+
+    printResult(r);
+}
+
+// objects-no-tables : the same with every chip settling its netlist instead of using a truth table
+static void benchObjects(const BenchCircuit& circuit, bool truthTables) {
+    std::string benchmark = truthTables ? "objects" : "objects-no-tables";
+    if (!selected(benchmark, circuit.name)) { return; }
+
+    BenchResult r;
+    r.benchmark = benchmark;
+    r.circuit = circuit.name;
+
+    int tableInputs = ChipDefinition::truthTableInputs;
+    if (!truthTables) {
+        ChipDefinition::truthTableInputs = 0;
+    }
+
+    std::vector<Gate*> gates;
+    loadCircuit(circuit, gates);
+    ChipDefinition::truthTableInputs = tableInputs;
+    r.gates = countGates(gates);
+
+    std::vector<Switch*> switches;
+    for (auto gate : gates) {
+        Switch* sw = dynamic_cast<Switch*>(gate);
+        if (sw != nullptr) {
+            switches.push_back(sw);
+        }
+    }
+
+    auto vectors = randomVectors(switches.size());
+
+    Simulation::settle(Simulation::settleEventCap);
+
+    measure(r, [&](long long n) {
+        Metrics::beginStep();
+        for (long long i = 0; i < n; i++) {
+            auto& vec = vectors[i % VECTOR_COUNT];
+            for (size_t s = 0; s < switches.size(); s++) {
+                switches[s]->setState(vec[s]);
+            }
+            Simulation::settle(Simulation::settleEventCap);
+        }
+        Metrics::endStep();
+
+        r.events = (double)Metrics::last.events;
+        r.evaluations = (double)Metrics::last.gateEvaluations;
+    });
+
+    // an oscillating circuit leaves events behind, they must not outlive the gates
+    while (!Simulation::updateQueue.empty()) {
+        Simulation::updateQueue.pop();
+    }
+
+    freeCircuit(gates);
+
+    printResult(r);
+}
+
+static void benchNetlist(const std::string& circuitName, const Netlist& netlist) {
+    if (!selected("netlist", circuitName)) { return; }
+
+    BenchResult r;
+    r.benchmark = "netlist";
+    r.circuit = circuitName;
+    r.gates = netlist.gateCount();
+
+    size_t before = liveBytes;
+    NetlistSimulation sim(netlist);
+    sim.settle(MAX_SETTLE_TICKS);
+    r.bytes = (double)(liveBytes - before);
+
+    auto vectors = randomVectors(netlist.primaryInputs.size());
+
+    measure(r, [&](long long n) {
+        uint64_t evaluations = sim.gateEvaluations;
+        for (long long i = 0; i < n; i++) {
+            auto& vec = vectors[i % VECTOR_COUNT];
+            for (size_t s = 0; s < vec.size(); s++) {
+                sim.setInput((int)s, vec[s]);
+            }
+            sim.settle(MAX_SETTLE_TICKS);
+        }
+        r.evaluations = (double)(sim.gateEvaluations - evaluations);
+    });
+
+    printResult(r);
+}
+
+static void benchTimed(const std::string& circuitName, const Netlist& netlist) {
+    if (!selected("timed", circuitName)) { return; }
+
+    BenchResult r;
+    r.benchmark = "timed";
+    r.circuit = circuitName;
+    r.gates = netlist.gateCount();
+
+    size_t before = liveBytes;
+    EventSimulation sim(netlist);
+    sim.settle(MAX_SETTLE_TICKS);
+    r.bytes = (double)(liveBytes - before);
+
+    auto vectors = randomVectors(netlist.primaryInputs.size());
+
+    measure(r, [&](long long n) {
+        uint64_t events = sim.eventsProcessed;
+        uint64_t evaluations = sim.gateEvaluations;
+        for (long long i = 0; i < n; i++) {
+            auto& vec = vectors[i % VECTOR_COUNT];
+            for (size_t s = 0; s < vec.size(); s++) {
+                sim.setInput((int)s, vec[s]);
+            }
+            sim.settle(MAX_SETTLE_TICKS);
+        }
+        r.events = (double)(sim.eventsProcessed - events);
+        r.evaluations = (double)(sim.gateEvaluations - evaluations);
+    });
+
+    printResult(r);
+}
+
+static void benchLevelized(const std::string& circuitName, const Netlist& netlist) {
+    if (!selected("levelized", circuitName)) { return; }
+
+    BenchResult r;
+    r.benchmark = "levelized";
+    r.circuit = circuitName;
+    r.gates = netlist.gateCount();
+
+    size_t before = liveBytes;
+    LevelizedSimulation sim(netlist);
+    r.bytes = (double)(liveBytes - before);
+
+    if (!sim.isValid()) { // latches
+        return;
+    }
+
+    auto vectors = randomVectors(netlist.primaryInputs.size());
+
+    measure(r, [&](long long n) {
+        for (long long i = 0; i < n; i++) {
+            auto& vec = vectors[i % VECTOR_COUNT];
+            for (size_t s = 0; s < vec.size(); s++) {
+                sim.setInput((int)s, vec[s]);
+            }
+            sim.evaluate();
+        }
+        r.evaluations = (double)n * sim.opCount();
+    });
+
+    printResult(r);
+}
+
+// Random patterns in every input word, then whole passes of Engine::Patterns vectors
+template<typename Engine>
+static void measurePatterns(BenchResult& r, Engine& sim, const Netlist& netlist) {
+    std::mt19937_64 rng(1);
+    const int words = Engine::Patterns / 64;
+    for (size_t s = 0; s < netlist.primaryInputs.size(); s++) {
+        for (int w = 0; w < words; w++) {
+            sim.setInput((int)s, w, rng());
+        }
+    }
+
+    size_t opCount = 0;
+    for (int g = 0; g < netlist.gateCount(); g++) {
+        if (netlist.types[g] != GateType::SWITCH) {
+            opCount++;
+        }
+    }
+
+    measure(r, [&](long long n) {
+        for (long long i = 0; i < n; i++) {
+            sim.evaluate();
+        }
+        r.evaluations = (double)n * opCount * Engine::Patterns; // one per gate per pattern
+    });
+
+    printResult(r);
+}
+
+static void benchPattern(const std::string& circuitName, const Netlist& netlist) {
+    if (!selected("pattern512", circuitName)) { return; }
+
+    BenchResult r;
+    r.benchmark = "pattern512";
+    r.circuit = circuitName;
+    r.gates = netlist.gateCount();
+
+    size_t before = liveBytes;
+    PatternSimulation512 sim(netlist);
+    r.bytes = (double)(liveBytes - before);
+
+    if (!sim.isValid()) {
+        return;
+    }
+
+    measurePatterns(r, sim, netlist);
+}
+
+// The kernel is compiled (or found in native-cache) before timing starts
+static void benchNative(const std::string& circuitName, const Netlist& netlist) {
+    if (!selected("native512", circuitName)) { return; }
+
+    BenchResult r;
+    r.benchmark = "native512";
+    r.circuit = circuitName;
+    r.gates = netlist.gateCount();
+
+    size_t before = liveBytes;
+    NativeSimulation sim(netlist);
+    r.bytes = (double)(liveBytes - before);
+
+    if (!sim.isValid()) {
+        if (sim.levelization.isCombinational()) {
+            std::cerr << "native512/" << circuitName << " skipped : " << sim.error << std::endl;
+        }
+        return;
+    }
+
+    measurePatterns(r, sim, netlist);
+}
+
+static void benchCircuit(const BenchCircuit& circuit) {
+    benchLoad(circuit);
+    benchObjects(circuit, true);
+    benchObjects(circuit, false);
+
+    // the netlist engines share one compiled netlist
+    Simulation::suspend();
+    std::vector<Gate*> gates;
+    loadCircuit(circuit, gates);
+    Simulation::resume();
+
+    benchOpenBinary(circuit.name, gates);
+
+    Netlist netlist = compileNetlist(gates);
+
+    benchNetlist(circuit.name, netlist);
+    benchTimed(circuit.name, netlist);
+    benchLevelized(circuit.name, netlist);
+    benchPattern(circuit.name, netlist);
+    benchNative(circuit.name, netlist);
+
+    freeCircuit(gates);
+}
+
+static BenchCircuit synthetic(const std::string& name, const GeneratedCircuit& generated) {
+    std::ostringstream oss;
+    generated.write(oss);
+    return BenchCircuit{ name, oss.str(), false };
+}
+
+static bool readFile(const std::string& path, std::string& out) {
+    std::ifstream ifs(path, std::ifstream::in);
+    if (!ifs) { return false; }
+
+    std::ostringstream oss;
+    oss << ifs.rdbuf();
+    out = oss.str();
+    return true;
+}
+
+static void usage() {
+    std::cerr << "usage : lgs-bench [--min-time seconds] [--bits n] [--filter text] [sample-dir]" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    int bits = DEFAULT_SYNTHETIC_BITS;
+    std::string dir = ".";
+    int arg = 1;
+
+    for (; arg < argc && argv[arg][0] == '-' && argv[arg][1] == '-'; arg++) {
+        std::string option = argv[arg];
+        if (option == "--min-time" && arg + 1 < argc) {
+            minTime = std::stod(argv[++arg]);
+        }
+        else if (option == "--bits" && arg + 1 < argc) {
+            bits = std::stoi(argv[++arg]);
+        }
+        else if (option == "--filter" && arg + 1 < argc) {
+            filter = argv[++arg];
+        }
+        else {
+            usage();
+            return 1;
+        }
+    }
+
+    if (arg < argc) {
+        dir = argv[arg];
+    }
+
+    static const struct { const char* file; bool recursive; } samples[] = {
+        { "full-adder.txt", false },
+        { "4-bit-adder.txt", true },
+        { "mem-cell.txt", true },
+        { "4-bit-register.txt", true },
+    };
+
+    std::vector<BenchCircuit> circuits;
+
+    for (auto& sample : samples) {
+        BenchCircuit circuit{ sample.file, "", sample.recursive };
+        if (!readFile(dir + "/" + sample.file, circuit.text)) {
+            std::cerr << "cannot open " << dir << "/" << sample.file << ", skipped" << std::endl;
+            continue;
+        }
+        circuits.push_back(circuit);
+    }
+
+    GeneratedCircuit adder;
+    generateRippleAdder(adder, bits);
+    circuits.push_back(synthetic("ripple-adder-" + std::to_string(bits), adder));
+
+    GeneratedCircuit dag;
+    generateRandomDag(dag, 64, bits * 8, bits * 8, 4, 1);
+    circuits.push_back(synthetic("random-" + std::to_string(bits * 8), dag));
+
+    printHeader();
+
+    for (auto& circuit : circuits) {
+        benchCircuit(circuit);
+    }
+
+    return 0;
+}
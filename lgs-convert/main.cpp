@@ -0,0 +1,110 @@
+// lgs-convert : converts save files between the text formats and the memory mapped binary one.
+//
+//   lgs-convert [--plain] <input> <output>
+//
+// A text input (recursive format, or the Ctrl+S one with --plain) is written as a binary save; a binary
+// input (recognized by its header) is written back as text, recursive unless --plain is given. --plain
+// text only holds a single circuit, so it refuses binaries with chips.
+// The binary layout is described in LogicCore/BinaryFormat.h.
+
+#include "BinaryFormat.h"
+#include "Gate.h"
+#include "GatePool.h"
+#include "Serialization.h"
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static void usage() {
+    std::cerr << "usage : lgs-convert [--plain] <input> <output>" << std::endl;
+}
+
+static bool toText(const std::string& input, std::ofstream& ofs, bool plain) {
+    BinaryCircuitFile file;
+    if (!file.open(input)) {
+        return false;
+    }
+
+    if (plain && file.circuitCount() > 1) {
+        std::cerr << input << " has chips, it cannot be written as a --plain save" << std::endl;
+        return false;
+    }
+
+    std::vector<Gate*> gates;
+    GatePool pool;
+    std::vector<ChipDefinition*> made;
+    loadFromBinary(gates, file, &pool, &made);
+
+    if (plain) {
+        saveToFile(gates, ofs);
+    }
+    else {
+        saveToFileRecursively(gates, ofs);
+    }
+
+    std::cerr << input << " : " << file.circuitCount() << " circuits, " << file.getTopLevel().gateCount << " top level gates" << std::endl;
+
+    pool.clear();
+    deleteDefinitions(made); // after their chips
+    return true;
+}
+
+static bool toBinary(const std::string& input, std::ofstream& ofs, bool plain) {
+    std::ifstream ifs(input, std::ifstream::in);
+    if (!ifs) {
+        std::cerr << "cannot open " << input << std::endl;
+        return false;
+    }
+
+    std::vector<Gate*> gates;
+    GatePool pool;
+    std::vector<ChipDefinition*> made;
+    if (plain) {
+        loadFromFile(gates, ifs, nullptr, &pool);
+    }
+    else {
+        loadFromFileRecursively(gates, ifs, &pool, &made);
+    }
+
+    saveToBinary(gates, ofs);
+
+    std::cerr << input << " : " << gates.size() << " top level gates" << std::endl;
+
+    pool.clear();
+    deleteDefinitions(made); // after their chips
+
+    return true;
+}
+
+int main(int argc, char** argv) {
+    bool plain = false;
+    int arg = 1;
+
+    if (arg < argc && std::string(argv[arg]) == "--plain") {
+        plain = true;
+        arg++;
+    }
+
+    if (argc - arg != 2) {
+        usage();
+        return 1;
+    }
+
+    std::string input = argv[arg];
+    std::string output = argv[arg + 1];
+    bool binaryInput = isBinaryFile(input);
+
+    std::ofstream ofs(output, binaryInput ? std::ofstream::out : std::ofstream::out | std::ofstream::binary);
+    if (!ofs) {
+        std::cerr << "cannot open " << output << std::endl;
+        return 1;
+    }
+
+    bool converted = binaryInput ? toText(input, ofs, plain) : toBinary(input, ofs, plain);
+
+    ofs.close();
+
+    return converted && ofs ? 0 : 1;
+}
@@ -0,0 +1,141 @@
+// lgs-gen : writes synthetic circuits as save files, for testing the loader, the engines and the editor at scale.
+//
+//   lgs-gen [--plain | --binary] [-o file] ripple-adder <bits>
+//   lgs-gen [--plain | --binary] [-o file] cla-adder <bits>
+//   lgs-gen [--plain | --binary] [-o file] multiplier <bits>
+//   lgs-gen [--plain | --binary] [-o file] lfsr <bits>
+//   lgs-gen [--plain | --binary] [-o file] counter <bits>
+//   lgs-gen [--plain | --binary] [-o file] register-file <registers> <bits>
+//   lgs-gen [--plain | --binary] [-o file] random <inputs> <gates> [window] [max-fanout] [seed]
+//
+// Without -o the save file goes to stdout. The default format is the recursive one (Ctrl+B / lgs-sim),
+// --plain writes the single-circuit one (Ctrl+O / lgs-sim --plain), --binary the memory mapped one
+// (LogicCore/BinaryFormat.h), which needs -o.
+// Pin order of each kind is documented in LogicCore/CircuitGenerator.h. The sequential circuits
+// (lfsr, counter) advance on a rising clk; register-file stores while we is high.
+// random : window defaults to 64, max-fanout to 4 and seed to 1.
+
+#include "CircuitGenerator.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#define OUTPUT_BUFFER_SIZE (1 << 20)
+
+static void usage() {
+    std::cerr << "usage : lgs-gen [--plain | --binary] [-o file] <kind> <size ...>" << std::endl;
+    std::cerr << "        kinds : ripple-adder <bits>, cla-adder <bits>, multiplier <bits>, lfsr <bits>, counter <bits>," << std::endl;
+    std::cerr << "                register-file <registers> <bits>, random <inputs> <gates> [window] [max-fanout] [seed]" << std::endl;
+}
+
+static bool generate(GeneratedCircuit& circuit, const std::string& kind, const std::vector<int>& sizes) {
+    auto size = [&](size_t i, int fallback) {
+        return i < sizes.size() ? sizes[i] : fallback;
+    };
+
+    if (sizes.empty() || sizes[0] < 1) {
+        return false;
+    }
+
+    if (kind == "ripple-adder") {
+        generateRippleAdder(circuit, sizes[0]);
+    }
+    else if (kind == "cla-adder") {
+        generateCarryLookaheadAdder(circuit, sizes[0]);
+    }
+    else if (kind == "multiplier") {
+        generateArrayMultiplier(circuit, sizes[0]);
+    }
+    else if (kind == "lfsr" && sizes[0] >= 2) {
+        generateLfsr(circuit, sizes[0]);
+    }
+    else if (kind == "counter") {
+        generateCounter(circuit, sizes[0]);
+    }
+    else if (kind == "register-file" && sizes[0] >= 2 && size(1, 0) >= 1) {
+        generateRegisterFile(circuit, sizes[0], sizes[1]);
+    }
+    else if (kind == "random" && size(1, 0) >= 1) {
+        generateRandomDag(circuit, sizes[0], sizes[1], std::max(size(2, 64), 1), std::max(size(3, 4), 1), (uint32_t)size(4, 1));
+    }
+    else {
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv) {
+    bool plain = false;
+    bool binary = false;
+    std::string outputFile;
+    int arg = 1;
+
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        std::string option = argv[arg];
+        if (option == "--plain") {
+            plain = true;
+        }
+        else if (option == "--binary") {
+            binary = true;
+        }
+        else if (option == "-o" && arg + 1 < argc) {
+            outputFile = argv[++arg];
+        }
+        else {
+            usage();
+            return 1;
+        }
+    }
+
+    if (arg >= argc || (binary && (plain || outputFile.empty()))) {
+        usage();
+        return 1;
+    }
+
+    std::string kind = argv[arg++];
+    std::vector<int> sizes;
+    for (; arg < argc; arg++) {
+        sizes.push_back(std::atoi(argv[arg]));
+    }
+
+    GeneratedCircuit circuit;
+    if (!generate(circuit, kind, sizes)) {
+        usage();
+        return 1;
+    }
+
+    std::ofstream ofs;
+    std::vector<char> buffer(OUTPUT_BUFFER_SIZE);
+
+    if (!outputFile.empty()) {
+        ofs.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+        ofs.open(outputFile, binary ? std::ofstream::out | std::ofstream::binary : std::ofstream::out);
+        if (!ofs) {
+            std::cerr << "cannot open " << outputFile << std::endl;
+            return 1;
+        }
+    }
+
+    std::ostream& out = outputFile.empty() ? std::cout : ofs;
+
+    if (binary) {
+        circuit.writeBinary(out);
+    }
+    else if (plain) {
+        circuit.write(out);
+    }
+    else {
+        circuit.writeRecursive(out);
+    }
+
+    out.flush();
+
+    std::cerr << kind << " : " << circuit.gateCount() << " gates, " << circuit.connectionCount() << " connections" << std::endl;
+
+    return out ? 0 : 1;
+}
@@ -0,0 +1,501 @@
+// lgs-sim : headless driver for the logic core.
+//
+// Loads a save file, applies input vectors to its switches and prints what its lights show.
+//
+//   lgs-sim [--plain] [--optimize] [--no-truth-tables] [--metrics file] [--vcd file [--vcd-all]] [--netlist | --levelized [--threads n] | --timed [--delay type=n ...]] <save-file> [vector ...]
+//   lgs-sim [--plain] [--optimize] --exhaustive [--native] <save-file>
+//
+// A vector is a string of 0/1 characters, one per switch, in save-file order.
+// Without vectors on the command line they are read from stdin, one per line.
+// --plain loads a single-circuit save (Ctrl+S / full-adder.txt) instead of a recursive one.
+// Binary saves (lgs-convert, lgs-gen --binary) are recognized by their header; the netlist engines compile
+// them straight from the memory mapping, without creating gate objects.
+// --netlist flattens the circuit and simulates the netlist instead of the gate objects.
+// --levelized evaluates a combinational netlist in one pass per vector, gates sorted by level.
+// --threads spreads --levelized evaluation of large levels over n threads (0 = one per core).
+// --exhaustive prints the whole truth table of a combinational circuit, 512 input patterns per pass.
+// --optimize runs the netlist engines on the optimized netlist (NetlistOptimizer.h) and prints what it removed to stderr.
+// --native makes --exhaustive run the netlist compiled to machine code by the installed C++ compiler
+//   (NativeSimulation.h), kept in native-cache/ so a design is only compiled once.
+// --timed runs the netlist on the timing wheel with per gate type delays and prints when each vector settled.
+// --delay sets the delay of one gate type for --timed, e.g. --delay xor=3 (types : or, and, not, xor; delays are 0 or more).
+// --no-truth-tables makes the chips of the object simulation settle their netlist on every input change
+//   instead of looking their outputs up (ChipDefinition.h).
+// --metrics writes one CSV row per vector of the object simulation (events, gate evaluations, queue depth, time).
+// --vcd records the inputs and outputs as a VCD waveform (--vcd-all : every net / gate output) for the object,
+//   --netlist and --timed simulations. Time is in delta cycles, or in gate delays with --timed.
+
+#include "BinaryFormat.h"
+#include "ChipDefinition.h"
+#include "EventScheduler.h"
+#include "Gate.h"
+#include "GatePool.h"
+#include "IntegratedChip.h"
+#include "LevelizedSimulation.h"
+#include "Metrics.h"
+#include "NativeSimulation.h"
+#include "Netlist.h"
+#include "NetlistOptimizer.h"
+#include "ParallelSimulation.h"
+#include "PatternSimulation.h"
+#include "Serialization.h"
+#include "Simulation.h"
+#include "WaveformRecorder.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define MAX_SETTLE_TICKS 100000
+#define MAX_EXHAUSTIVE_INPUTS 30
+
+static WaveformRecorder* waveform = nullptr; // set by --vcd
+static bool waveformAllNets = false;
+
+static void usage() {
+    std::cerr << "usage : lgs-sim [--plain] [--optimize] [--no-truth-tables] [--metrics file] [--vcd file [--vcd-all]] [--netlist | --levelized [--threads n] | --timed [--delay type=n ...]] <save-file> [vector ...]" << std::endl;
+    std::cerr << "        lgs-sim [--plain] [--optimize] --exhaustive [--native] <save-file>" << std::endl;
+}
+
+static bool checkVector(const std::string& vec, size_t inputCount) {
+    if (vec.size() != inputCount) {
+        std::cerr << "vector '" << vec << "' has " << vec.size() << " bits, circuit has " << inputCount << " inputs" << std::endl;
+        return false;
+    }
+
+    for (size_t i = 0; i < vec.size(); i++) {
+        if (vec[i] != '0' && vec[i] != '1') {
+            std::cerr << "vector '" << vec << "' is not made of 0/1" << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void printResult(const std::string& vec, const std::string& outputs, bool settled) {
+    std::cout << vec << " -> " << outputs;
+    if (!settled) {
+        std::cout << " (did not settle)";
+    }
+    std::cout << std::endl;
+}
+
+static void runObjects(std::vector<Gate*>& gates, const std::vector<std::string>& vectors) {
+    std::vector<Switch*> switches;
+    std::vector<Light*> lights;
+
+    for (auto gate : gates) {
+        Switch* sw = dynamic_cast<Switch*>(gate);
+        if (sw != nullptr) {
+            switches.push_back(sw);
+            continue;
+        }
+
+        Light* lt = dynamic_cast<Light*>(gate);
+        if (lt != nullptr) {
+            lights.push_back(lt);
+        }
+    }
+
+    Simulation::settle(Simulation::settleEventCap); // let the NOT gates and initial connections propagate
+
+    if (waveform != nullptr) {
+        addCircuitSignals(*waveform, gates, waveformAllNets);
+        waveform->start();
+        Simulation::recorder = waveform;
+    }
+
+    for (auto& vec : vectors) {
+        if (!checkVector(vec, switches.size())) { continue; }
+
+        for (size_t i = 0; i < vec.size(); i++) {
+            switches[i]->setState(vec[i] == '1');
+        }
+
+        Metrics::beginStep();
+        bool settled = Simulation::settle(Simulation::settleEventCap);
+        Metrics::endStep();
+
+        std::string outputs;
+        for (auto lt : lights) {
+            outputs += lt->getState() ? '1' : '0';
+        }
+        printResult(vec, outputs, settled);
+    }
+
+    Simulation::recorder = nullptr;
+}
+
+static void runNetlist(const Netlist& netlist, const std::vector<std::string>& vectors) {
+    NetlistSimulation sim(netlist);
+
+    sim.settle(MAX_SETTLE_TICKS);
+
+    if (waveform != nullptr) {
+        sim.record(waveform, addNetlistSignals(*waveform, netlist, sim.netStates, waveformAllNets));
+        waveform->start();
+    }
+
+    for (auto& vec : vectors) {
+        if (!checkVector(vec, netlist.primaryInputs.size())) { continue; }
+
+        for (size_t i = 0; i < vec.size(); i++) {
+            sim.setInput((int)i, vec[i] == '1');
+        }
+
+        bool settled = sim.settle(MAX_SETTLE_TICKS);
+
+        std::string outputs;
+        for (size_t i = 0; i < netlist.primaryOutputs.size(); i++) {
+            outputs += sim.getOutput((int)i) ? '1' : '0';
+        }
+        printResult(vec, outputs, settled);
+    }
+}
+
+template<typename Engine>
+static bool runLevelizedEngine(Engine& sim, const Netlist& netlist, const std::vector<std::string>& vectors) {
+    if (!sim.isValid()) {
+        std::cerr << "circuit has a feedback loop (through netlist gate " << sim.levelization.feedbackGate << "), cannot levelize" << std::endl;
+        return false;
+    }
+
+    for (auto& vec : vectors) {
+        if (!checkVector(vec, netlist.primaryInputs.size())) { continue; }
+
+        for (size_t i = 0; i < vec.size(); i++) {
+            sim.setInput((int)i, vec[i] == '1');
+        }
+
+        sim.evaluate();
+
+        std::string outputs;
+        for (size_t i = 0; i < netlist.primaryOutputs.size(); i++) {
+            outputs += sim.getOutput((int)i) ? '1' : '0';
+        }
+        printResult(vec, outputs, true);
+    }
+
+    return true;
+}
+
+static bool runLevelized(const Netlist& netlist, const std::vector<std::string>& vectors, int threads) {
+    if (threads < 0) {
+        LevelizedSimulation sim(netlist);
+        return runLevelizedEngine(sim, netlist, vectors);
+    }
+
+    ThreadPool pool(threads);
+    ParallelSimulation sim(netlist, pool);
+    return runLevelizedEngine(sim, netlist, vectors);
+}
+
+template<typename Engine>
+static bool runExhaustiveEngine(Engine& sim, const Netlist& netlist) {
+    int inputCount = (int)netlist.primaryInputs.size();
+    int outputCount = (int)netlist.primaryOutputs.size();
+
+    if (inputCount > MAX_EXHAUSTIVE_INPUTS) {
+        std::cerr << "circuit has " << inputCount << " inputs, exhaustive runs are limited to " << MAX_EXHAUSTIVE_INPUTS << std::endl;
+        return false;
+    }
+
+    uint64_t total = 1ull << inputCount;
+    const int words = Engine::Patterns / 64;
+
+    for (uint64_t first = 0; first < total; first += Engine::Patterns) {
+        for (int w = 0; w < words; w++) {
+            for (int i = 0; i < inputCount; i++) {
+                sim.setInput(i, w, exhaustiveInputBits(i, inputCount, first + w * 64));
+            }
+        }
+
+        sim.evaluate();
+
+        for (uint64_t p = first; p < total && p < first + Engine::Patterns; p++) {
+            int w = (int)((p - first) / 64);
+            int bit = (int)(p % 64);
+
+            std::string vec, outputs;
+            for (int i = 0; i < inputCount; i++) {
+                vec += ((p >> (inputCount - 1 - i)) & 1) ? '1' : '0';
+            }
+            for (int o = 0; o < outputCount; o++) {
+                outputs += ((sim.getOutput(o, w) >> bit) & 1) ? '1' : '0';
+            }
+            printResult(vec, outputs, true);
+        }
+    }
+
+    return true;
+}
+
+static bool runExhaustive(const Netlist& netlist, bool native) {
+    if (native) {
+        NativeSimulation sim(netlist);
+        if (!sim.isValid()) {
+            std::cerr << "no native kernel : " << sim.error << std::endl;
+            return false;
+        }
+        return runExhaustiveEngine(sim, netlist);
+    }
+
+    PatternSimulation512 sim(netlist);
+    if (!sim.isValid()) {
+        std::cerr << "circuit has a feedback loop (through netlist gate " << sim.levelization.feedbackGate << "), cannot levelize" << std::endl;
+        return false;
+    }
+    return runExhaustiveEngine(sim, netlist);
+}
+
+static void runTimed(const Netlist& netlist, const std::vector<std::string>& vectors, const GateDelays& delays) {
+    EventSimulation sim(netlist, delays);
+
+    if (!sim.settle(MAX_SETTLE_TICKS)) {
+        std::cerr << "initial state did not settle" << std::endl;
+    }
+
+    if (waveform != nullptr) {
+        sim.record(waveform, addNetlistSignals(*waveform, netlist, sim.netStates, waveformAllNets));
+        waveform->start();
+    }
+
+    for (auto& vec : vectors) {
+        if (!checkVector(vec, netlist.primaryInputs.size())) { continue; }
+
+        for (size_t i = 0; i < vec.size(); i++) {
+            sim.setInput((int)i, vec[i] == '1');
+        }
+
+        SimTime start = sim.now();
+        bool settled = sim.settle(MAX_SETTLE_TICKS);
+
+        std::string outputs;
+        for (size_t i = 0; i < netlist.primaryOutputs.size(); i++) {
+            outputs += sim.getOutput((int)i) ? '1' : '0';
+        }
+        outputs += " @" + std::to_string(sim.now() - start);
+        printResult(vec, outputs, settled);
+    }
+}
+
+// A whole number >= 0 with nothing after it
+static bool parseCount(const std::string& text, int& out) {
+    if (text.empty() || text[0] < '0' || text[0] > '9') { return false; }
+
+    char* end = nullptr;
+    errno = 0;
+    long value = std::strtol(text.c_str(), &end, 10);
+    if (*end != '\0' || errno == ERANGE || value > INT_MAX) { return false; }
+
+    out = (int)value;
+    return true;
+}
+
+static bool parseDelay(const std::string& spec, GateDelays& delays) {
+    static const char* names[] = { "or", "and", "not", "xor" };
+
+    size_t eq = spec.find('=');
+    if (eq == std::string::npos) { return false; }
+
+    std::string name = spec.substr(0, eq);
+    for (int t = 0; t < 4; t++) {
+        if (name == names[t]) {
+            return parseCount(spec.substr(eq + 1), delays[(GateType)t]);
+        }
+    }
+
+    return false;
+}
+
+int main(int argc, char** argv) {
+    bool plain = false;
+    bool useNetlist = false;
+    bool timed = false;
+    bool levelized = false;
+    bool exhaustive = false;
+    bool optimize = false;
+    bool native = false;
+    int threads = -1;
+    std::string vcdFile;
+    GateDelays delays;
+    int arg = 1;
+
+    for (; arg < argc && argv[arg][0] == '-' && argv[arg][1] == '-'; arg++) {
+        std::string option = argv[arg];
+        if (option == "--plain") {
+            plain = true;
+        }
+        else if (option == "--optimize") {
+            optimize = true;
+        }
+        else if (option == "--no-truth-tables") {
+            ChipDefinition::truthTableInputs = 0;
+        }
+        else if (option == "--netlist") {
+            useNetlist = true;
+        }
+        else if (option == "--levelized") {
+            levelized = true;
+        }
+        else if (option == "--threads" && arg + 1 < argc && parseCount(argv[arg + 1], threads)) {
+            arg++;
+        }
+        else if (option == "--exhaustive") {
+            exhaustive = true;
+        }
+        else if (option == "--native") {
+            native = true;
+        }
+        else if (option == "--timed") {
+            timed = true;
+        }
+        else if (option == "--delay" && arg + 1 < argc && parseDelay(argv[arg + 1], delays)) {
+            arg++;
+        }
+        else if (option == "--vcd" && arg + 1 < argc) {
+            vcdFile = argv[++arg];
+        }
+        else if (option == "--vcd-all") {
+            waveformAllNets = true;
+        }
+        else if (option == "--metrics" && arg + 1 < argc) {
+            if (!Metrics::startDump(argv[++arg], 1)) {
+                std::cerr << "cannot open " << argv[arg] << std::endl;
+                return 1;
+            }
+        }
+        else {
+            usage();
+            return 1;
+        }
+    }
+
+    if (arg >= argc) {
+        usage();
+        return 1;
+    }
+
+    WaveformRecorder recorder;
+    if (!vcdFile.empty()) {
+        if (exhaustive || levelized) {
+            std::cerr << "--vcd records the object, --netlist and --timed simulations only" << std::endl;
+            return 1;
+        }
+        if (!recorder.open(vcdFile)) {
+            std::cerr << "cannot open " << vcdFile << std::endl;
+            return 1;
+        }
+        waveform = &recorder;
+    }
+
+    std::string saveFile = argv[arg++];
+    bool netlistOnly = exhaustive || levelized || timed || useNetlist;
+
+    if (native && !exhaustive) {
+        std::cerr << "--native applies to --exhaustive" << std::endl;
+        return 1;
+    }
+
+    if (optimize && !netlistOnly) {
+        std::cerr << "--optimize applies to the --netlist, --levelized, --timed and --exhaustive simulations" << std::endl;
+        return 1;
+    }
+
+    std::vector<Gate*> gates;
+    GatePool pool; // the loaded gates, freed together on exit
+    std::vector<ChipDefinition*> made; // the chips of the save, freed after pool
+    Netlist netlist;
+
+    if (isBinaryFile(saveFile)) {
+        BinaryCircuitFile file;
+        if (!file.open(saveFile)) {
+            return 1;
+        }
+
+        // the netlist engines never need gate objects, compile straight from the mapping
+        if (netlistOnly) {
+            netlist = compileNetlist(file);
+        }
+        else {
+            loadFromBinary(gates, file, &pool, &made);
+        }
+    }
+    else {
+        std::ifstream ifs(saveFile, std::ifstream::in);
+        if (!ifs) {
+            std::cerr << "cannot open " << saveFile << std::endl;
+            return 1;
+        }
+
+        if (plain) {
+            loadFromFile(gates, ifs, nullptr, &pool);
+        }
+        else {
+            loadFromFileRecursively(gates, ifs, &pool, &made);
+        }
+
+        ifs.close();
+
+        if (netlistOnly) {
+            netlist = compileNetlist(gates);
+        }
+    }
+
+    if (optimize) {
+        OptimizedNetlist optimized = optimizeNetlist(netlist);
+        std::cerr << "optimized " << netlist.gateCount() << " -> " << optimized.netlist.gateCount() << " gates : "
+                  << optimized.foldedGates << " folded, " << optimized.inversions << " double inversions, "
+                  << optimized.mergedGates << " merged, " << optimized.deadGates << " dead" << std::endl;
+        netlist = std::move(optimized.netlist);
+    }
+
+    std::vector<std::string> vectors;
+    if (exhaustive) {
+        // inputs are enumerated
+    }
+    else if (arg < argc) {
+        for (; arg < argc; arg++) {
+            vectors.push_back(argv[arg]);
+        }
+    }
+    else {
+        std::string line;
+        while (std::getline(std::cin, line)) {
+            if (line.empty()) { continue; }
+            vectors.push_back(line);
+        }
+    }
+
+    int result = 0;
+
+    if (exhaustive) {
+        result = runExhaustive(netlist, native) ? 0 : 1;
+    }
+    else if (levelized) {
+        result = runLevelized(netlist, vectors, threads) ? 0 : 1;
+    }
+    else if (timed) {
+        runTimed(netlist, vectors, delays);
+    }
+    else if (useNetlist) {
+        runNetlist(netlist, vectors);
+    }
+    else {
+        runObjects(gates, vectors);
+    }
+
+    Metrics::stopDump();
+    recorder.close();
+
+    pool.clear();
+    deleteDefinitions(made); // after their chips
+
+    return result;
+}
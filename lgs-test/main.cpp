@@ -0,0 +1,1098 @@
+// lgs-test : regression tests for the logic core.
+//
+//   lgs-test
+//
+// Runs every test, prints one line per test and exits with 1 if any failed. Temporary files are
+// written to the working directory and removed afterwards; the native kernels are built into
+// NATIVE_CACHE_DIRECTORY there, like lgs-sim --native, and kept.
+
+#include "BinaryFormat.h"
+#include "ChipCache.h"
+#include "ChipDefinition.h"
+#include "ChipLibrary.h"
+#include "CircuitGenerator.h"
+#include "EventScheduler.h"
+#include "Gate.h"
+#include "GatePool.h"
+#include "Hash.h"
+#include "IntegratedChip.h"
+#include "LevelizedSimulation.h"
+#include "NativeSimulation.h"
+#include "Netlist.h"
+#include "NetlistOptimizer.h"
+#include "PatternSimulation.h"
+#include "Serialization.h"
+#include "Simulation.h"
+#include "TopologicalOrder.h"
+
+#include <cstdio>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define MAX_SETTLE_TICKS 100000
+#define TEST_BINARY_FILE "lgs-test.lgsb"
+#define TEST_TEXT_FILE "lgs-test.txt"
+#define TEST_CACHE_DIRECTORY "lgs-test-cache"
+#define AGREEMENT_INPUTS 10 // of the random circuit every engine is compared on, all 2^n patterns are run
+#define AGREEMENT_GATES 400
+#define AGREEMENT_SEED 7
+
+static int failures = 0;
+
+static void report(const std::string& name, bool passed, const std::string& reason) {
+    if (passed) {
+        std::cout << "pass " << name << std::endl;
+    }
+    else {
+        std::cout << "FAIL " << name << " : " << reason << std::endl;
+        failures++;
+    }
+}
+
+static void wire(Gate* from, int output, Gate* to, int input) {
+    Pin::connectPins(from->getPinByIndex(PinType::Output, output), to->getPinByIndex(PinType::Input, input));
+}
+
+// Chip template : switch -> NOT -> light
+static ChipDefinition* makeInverter(GatePool& pool) {
+    std::vector<Gate*>* circuit = new std::vector<Gate*>();
+    Simulation::suspend();
+
+    Gate* in = pool.create<Switch>();
+    Gate* inverter = pool.create<NOTGate>();
+    Gate* out = pool.create<Light>();
+    wire(in, 0, inverter, 0);
+    wire(inverter, 0, out, 0);
+    *circuit = { in, inverter, out };
+
+    Simulation::resume();
+    return new ChipDefinition(circuit, "INV");
+}
+
+// Chip template : switch -> inverter -> inverter -> light, two instances of one definition
+static ChipDefinition* makeBuffer(GatePool& pool, ChipDefinition* inverter) {
+    std::vector<Gate*>* circuit = new std::vector<Gate*>();
+    Simulation::suspend();
+
+    Gate* in = pool.create<Switch>();
+    Gate* first = pool.createChip(inverter);
+    Gate* second = pool.createChip(inverter);
+    Gate* out = pool.create<Light>();
+    wire(in, 0, first, 0);
+    wire(first, 0, second, 0);
+    wire(second, 0, out, 0);
+    *circuit = { in, first, second, out };
+
+    Simulation::resume();
+    return new ChipDefinition(circuit, "BUF");
+}
+
+// Top level : a buffer listed before an inverter, so the inverter definition is reached both directly
+// and through the buffer. a -> buffer -> x, b -> inverter -> y
+static void makeSharedNested(GatePool& pool, std::vector<Gate*>& gates) {
+    ChipDefinition* inverter = makeInverter(pool);
+    ChipDefinition* buffer = makeBuffer(pool, inverter);
+
+    Gate* bufferChip = pool.createChip(buffer);
+    Gate* inverterChip = pool.createChip(inverter);
+    Gate* a = pool.create<Switch>();
+    Gate* b = pool.create<Switch>();
+    Gate* x = pool.create<Light>();
+    Gate* y = pool.create<Light>();
+    wire(a, 0, bufferChip, 0);
+    wire(bufferChip, 0, x, 0);
+    wire(b, 0, inverterChip, 0);
+    wire(inverterChip, 0, y, 0);
+
+    gates = { bufferChip, inverterChip, a, b, x, y };
+}
+
+// Outputs of the netlist for every input pattern, one 0/1 string per pattern
+static std::string truthTable(const Netlist& netlist) {
+    std::string table;
+    int inputs = (int)netlist.primaryInputs.size();
+
+    for (int pattern = 0; pattern < (1 << inputs); pattern++) {
+        NetlistSimulation sim(netlist);
+        for (int i = 0; i < inputs; i++) {
+            sim.setInput(i, (pattern >> i) & 1);
+        }
+        sim.settle(MAX_SETTLE_TICKS);
+
+        for (size_t o = 0; o < netlist.primaryOutputs.size(); o++) {
+            table += sim.getOutput((int)o) ? '1' : '0';
+        }
+        table += ' ';
+    }
+
+    return table;
+}
+
+// Every circuit once, after the circuits of the chips it holds, the top level last
+static bool checkOrder(std::vector<Gate*>& gates, std::string& reason) {
+    std::vector<CircuitPtr> list = topoSort(&gates);
+
+    if (list.size() != 3) {
+        reason = std::to_string(list.size()) + " circuits listed instead of 3";
+        return false;
+    }
+    if (list.back() != &gates) {
+        reason = "top level is not last";
+        return false;
+    }
+
+    for (size_t c = 0; c < list.size(); c++) {
+        for (Gate* gate : *list[c]) {
+            IntegratedChip* ic = dynamic_cast<IntegratedChip*>(gate);
+            if (ic == nullptr) { continue; }
+
+            int index = getIndex(list, ic->definition->getCircuit());
+            if (index == -1 || index >= (int)c) {
+                reason = "circuit " + std::to_string(c) + " listed before a chip it holds";
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static void testTopoSortSharedNested() {
+    GatePool pool;
+    std::vector<Gate*> gates;
+    makeSharedNested(pool, gates);
+
+    std::string reason;
+    report("topoSort shared nested definition", checkOrder(gates, reason), reason);
+}
+
+static void testTextRoundTripSharedNested() {
+    GatePool pool;
+    std::vector<Gate*> gates;
+    makeSharedNested(pool, gates);
+    std::string expected = truthTable(compileNetlist(gates));
+
+    std::stringstream saved;
+    saveToFileRecursively(gates, saved);
+
+    GatePool loadedPool;
+    std::vector<Gate*> loaded;
+    std::vector<ChipDefinition*> made;
+    loadFromFileRecursively(loaded, saved, &loadedPool, &made);
+
+    std::string reason;
+    bool passed = checkOrder(loaded, reason);
+    if (passed && loaded.size() != gates.size()) {
+        reason = std::to_string(loaded.size()) + " top level gates loaded instead of " + std::to_string(gates.size());
+        passed = false;
+    }
+    if (passed) {
+        std::string actual = truthTable(compileNetlist(loaded));
+        if (actual != expected) {
+            reason = "outputs " + actual + "instead of " + expected;
+            passed = false;
+        }
+    }
+    if (passed) {
+        std::stringstream again;
+        saveToFileRecursively(loaded, again);
+        if (again.str() != saved.str()) {
+            reason = "saving the loaded circuit gives a different file";
+            passed = false;
+        }
+    }
+
+    loadedPool.clear();
+    deleteDefinitions(made);
+
+    report("text round trip shared nested definition", passed, reason);
+}
+
+static void testBinaryRoundTripSharedNested() {
+    GatePool pool;
+    std::vector<Gate*> gates;
+    makeSharedNested(pool, gates);
+    std::string expected = truthTable(compileNetlist(gates));
+
+    {
+        std::ofstream ofs(TEST_BINARY_FILE, std::ofstream::out | std::ofstream::binary);
+        saveToBinary(gates, ofs);
+    }
+
+    std::string reason;
+    bool passed = true;
+
+    BinaryCircuitFile file;
+    if (!file.open(TEST_BINARY_FILE)) {
+        reason = "cannot open the written file";
+        passed = false;
+    }
+    if (passed && file.circuitCount() != 3) {
+        reason = std::to_string(file.circuitCount()) + " circuits written instead of 3";
+        passed = false;
+    }
+    if (passed) {
+        std::string mapped = truthTable(compileNetlist(file));
+        if (mapped != expected) {
+            reason = "mapped outputs " + mapped + "instead of " + expected;
+            passed = false;
+        }
+    }
+    if (passed) {
+        GatePool loadedPool;
+        std::vector<Gate*> loaded;
+        std::vector<ChipDefinition*> made;
+        loadFromBinary(loaded, file, &loadedPool, &made);
+
+        std::string actual = truthTable(compileNetlist(loaded));
+        if (actual != expected) {
+            reason = "loaded outputs " + actual + "instead of " + expected;
+            passed = false;
+        }
+        if (passed && (made.size() != 2 || loadedPool.size() != loaded.size())) {
+            reason = "the chip circuits were not made in pools of their own";
+            passed = false;
+        }
+
+        // the definitions must not need the board pool, clearing it first is what a new board does
+        loadedPool.clear();
+        deleteDefinitions(made);
+    }
+
+    file.close();
+    std::remove(TEST_BINARY_FILE);
+
+    report("binary round trip shared nested definition", passed, reason);
+}
+
+// A gate destroyed while its input is connected must leave its driver's fanout list
+static void testDestroyConnectedGate() {
+    GatePool pool;
+    Gate* source = pool.create<Switch>();
+    Gate* first = pool.create<NOTGate>();
+    Gate* second = pool.create<NOTGate>();
+    wire(source, 0, first, 0);
+    wire(source, 0, second, 0);
+
+    pool.destroy(first);
+
+    Pin* output = source->getPinByIndex(PinType::Output, 0);
+    FanoutRange fanout = output->getFanout();
+    bool passed = fanout.size() == 1 && *fanout.begin() == second->getPinByIndex(PinType::Input, 0);
+
+    pool.destroy(source);
+    passed = passed && second->getPinByIndex(PinType::Input, 0)->connectedTo == nullptr;
+
+    report("destroying connected gates unlinks their pins", passed, "stale fanout entries or connections");
+}
+
+// Chip template : two independent inverters, input 0 -> output 0 and input 1 -> output 1
+static ChipDefinition* makeInverterPair(GatePool& pool) {
+    std::vector<Gate*>* circuit = new std::vector<Gate*>();
+    Simulation::suspend();
+
+    Gate* a = pool.create<Switch>();
+    Gate* b = pool.create<Switch>();
+    Gate* first = pool.create<NOTGate>();
+    Gate* second = pool.create<NOTGate>();
+    Gate* x = pool.create<Light>();
+    Gate* y = pool.create<Light>();
+    wire(a, 0, first, 0);
+    wire(first, 0, x, 0);
+    wire(b, 0, second, 0);
+    wire(second, 0, y, 0);
+    *circuit = { a, b, first, second, x, y };
+
+    Simulation::resume();
+    return new ChipDefinition(circuit, "PAIR");
+}
+
+// Output 0 wired back to input 1 goes through the chip, not around a loop; output 1 back to input 0 does loop
+static void testChipPinDependencies() {
+    GatePool templates;
+    ChipDefinition* pair = makeInverterPair(templates);
+
+    GatePool pool;
+    Gate* chip = pool.createChip(pair);
+    Gate* in = pool.create<Switch>();
+    Gate* out = pool.create<Light>();
+    std::vector<Gate*> gates = { chip, in, out };
+
+    TopologicalOrder order;
+    order.update(gates);
+
+    std::string reason;
+    bool passed = true;
+
+    Pin* output0 = chip->getPinByIndex(PinType::Output, 0);
+    Pin* output1 = chip->getPinByIndex(PinType::Output, 1);
+    Pin* input0 = chip->getPinByIndex(PinType::Input, 0);
+    Pin* input1 = chip->getPinByIndex(PinType::Input, 1);
+
+    Pin::connectPins(in->getPinByIndex(PinType::Output, 0), input0);
+    Pin::connectPins(output0, input1);
+    Pin::connectPins(output1, out->getPinByIndex(PinType::Input, 0));
+    if (!order.connect(in->getPinByIndex(PinType::Output, 0), input0) || !order.connect(output0, input1) ||
+        !order.connect(output1, out->getPinByIndex(PinType::Input, 0))) {
+        reason = "a connection through the chip was taken for a loop";
+        passed = false;
+    }
+
+    order.rebuild(gates);
+    if (passed && order.getFeedbackCount() != 0) {
+        reason = "rebuilding found " + std::to_string(order.getFeedbackCount()) + " feedback edges";
+        passed = false;
+    }
+
+    order.disconnect(in->getPinByIndex(PinType::Output, 0), input0);
+    Pin::connectPins(output1, input0);
+    if (passed && order.connect(output1, input0)) {
+        reason = "output 1 -> input 0 -> output 0 -> input 1 -> output 1 was not taken for a loop";
+        passed = false;
+    }
+
+    pool.clear();
+    delete pair;
+
+    report("chip pins only depend on the inputs they read", passed, reason);
+}
+
+// in -> XOR input 0, in -> NOT -> XOR input 1, XOR -> light : the light reads in XOR NOT in, always 1.
+// Settling in order updates every pin once and never lets the XOR output glitch through to the light.
+static void testSettleInOrder() {
+    GatePool pool;
+    Switch* in = pool.create<Switch>();
+    Gate* inverter = pool.create<NOTGate>();
+    Gate* xorGate = pool.create<XORGate>();
+    Gate* light = pool.create<Light>();
+    std::vector<Gate*> gates = { light, xorGate, inverter, in }; // the order has to be found
+
+    wire(in, 0, xorGate, 0);
+    wire(in, 0, inverter, 0);
+    wire(inverter, 0, xorGate, 1);
+    wire(xorGate, 0, light, 0);
+
+    TopologicalOrder order;
+    order.update(gates);
+
+    in->toggle();
+    order.settle();
+    in->toggle();
+    int updates = order.settle();
+
+    Pin* lightInput = light->getPinByIndex(PinType::Input, 0);
+    bool passed = updates == 4 && lightInput->cachedState && Simulation::isIdle();
+    report("settle in topological order", passed, std::to_string(updates) + " pin updates, light " + (lightInput->cachedState ? "on" : "off"));
+}
+
+// Chip template : switch -> light, a plain wire through the chip
+static ChipDefinition* makeWire(GatePool& pool) {
+    std::vector<Gate*>* circuit = new std::vector<Gate*>();
+    Simulation::suspend();
+
+    Gate* in = pool.create<Switch>();
+    Gate* out = pool.create<Light>();
+    wire(in, 0, out, 0);
+    *circuit = { in, out };
+
+    Simulation::resume();
+    return new ChipDefinition(circuit, "WIRE");
+}
+
+// A wire chip with its output fed back to its input : the net is only wires, nothing drives it, and
+// following it through the chip must stop instead of going round for ever
+static void testWireLoopThroughChip() {
+    GatePool templates;
+    ChipDefinition* wireChip = makeWire(templates);
+
+    GatePool pool;
+    Gate* chip = pool.createChip(wireChip);
+    Gate* out = pool.create<Light>();
+    wire(chip, 0, chip, 0);
+    wire(chip, 0, out, 0);
+    std::vector<Gate*> gates = { chip, out };
+
+    std::string actual = truthTable(compileNetlist(gates));
+    std::string reason = "outputs " + actual;
+    bool passed = actual == "0 ";
+
+    {
+        std::ofstream ofs(TEST_BINARY_FILE, std::ofstream::out | std::ofstream::binary);
+        saveToBinary(gates, ofs);
+    }
+    BinaryCircuitFile file;
+    if (passed && !file.open(TEST_BINARY_FILE)) {
+        reason = "cannot open the written file";
+        passed = false;
+    }
+    if (passed) {
+        std::string mapped = truthTable(compileNetlist(file));
+        reason = "mapped outputs " + mapped;
+        passed = mapped == "0 ";
+    }
+    file.close();
+    std::remove(TEST_BINARY_FILE);
+
+    pool.clear();
+    delete wireChip;
+
+    report("wire loop through a chip compiles to an undriven net", passed, reason);
+}
+
+// Save files whose connections name gates or pins that do not exist are refused, not dereferenced
+static void testLibraryRejectsBadIndices() {
+    const char* files[] = {
+        "2\n0 4 0 0\n1 5 0 0\n1\n7 0 0 0\n",  // input gate out of range
+        "2\n0 4 0 0\n1 5 0 0\n1\n1 0 5 0\n",  // output gate out of range
+        "2\n0 4 0 0\n1 5 0 0\n1\n1 3 0 0\n",  // input pin out of range
+        "2\n0 4 0 0\n1 5 0 0\n1\n1 0 0 1\n",  // output pin out of range
+        "2\n0 4 0 0\n1 5 0 0\n1\n0 0 1 0\n",  // a light has no output, a switch no input
+        "1\n0 9 0 0\n0\n",                      // unknown gate type
+    };
+
+    std::string reason;
+    bool passed = true;
+
+    for (const char* content : files) {
+        {
+            std::ofstream ofs(TEST_TEXT_FILE);
+            ofs << content;
+        }
+
+        // a new library each time, so the file is never taken from a previous get
+        ChipLibrary library;
+        if (library.get(TEST_TEXT_FILE, "BAD", false) != nullptr) {
+            reason = "accepted " + std::string(content);
+            passed = false;
+            break;
+        }
+    }
+
+    std::remove(TEST_TEXT_FILE);
+
+    report("chip library rejects out of range connections", passed, reason);
+}
+
+// A cache entry is only used for the source it was written for, even when another source has its key
+static void testCacheChecksSource() {
+    GatePool templates;
+    ChipDefinition* inverter = makeInverter(templates);
+
+    std::string source = "3\n0 4 0 0\n1 2 0 0\n2 5 0 0\n2\n1 0 0 0\n2 0 1 0\n";
+    std::string other = source + "\n";
+    uint64_t key = chipCacheKey(1, false); // both sources stand for a colliding hash
+
+    std::string reason;
+    bool passed = writeChipCache(TEST_CACHE_DIRECTORY, key, source, inverter->netlist, inverter->getInitialState());
+    if (!passed) {
+        reason = "cannot write the entry";
+    }
+
+    Netlist netlist;
+    std::vector<uint64_t> initialState;
+    if (passed && readChipCache(TEST_CACHE_DIRECTORY, key, other, netlist, initialState)) {
+        reason = "the entry was used for another source";
+        passed = false;
+    }
+    if (passed && (!readChipCache(TEST_CACHE_DIRECTORY, key, source, netlist, initialState) ||
+        truthTable(netlist) != truthTable(inverter->netlist) || initialState != inverter->getInitialState())) {
+        reason = "the entry does not give back what was written";
+        passed = false;
+    }
+
+    std::remove(chipCachePath(TEST_CACHE_DIRECTORY, key).c_str());
+    std::remove(TEST_CACHE_DIRECTORY);
+    delete inverter;
+
+    report("chip cache entries check their source", passed, reason);
+}
+
+// in -> NOT -> NOT -> light
+static Netlist makeChain(GatePool& pool) {
+    Simulation::suspend(); // only compiled, never simulated
+    Gate* in = pool.create<Switch>();
+    Gate* a = pool.create<NOTGate>();
+    Gate* b = pool.create<NOTGate>();
+    Gate* out = pool.create<Light>();
+    wire(in, 0, a, 0);
+    wire(a, 0, b, 0);
+    wire(b, 0, out, 0);
+
+    std::vector<Gate*> gates = { in, a, b, out };
+    Simulation::resume();
+
+    return compileNetlist(gates);
+}
+
+// Outputs of a netlist and of its optimized version must agree for every input
+static bool sameOutputs(const Netlist& netlist, const OptimizedNetlist& optimized, std::string& reason) {
+    std::string expected = truthTable(netlist);
+    std::string actual = truthTable(optimized.netlist);
+    if (actual != expected) {
+        reason = "optimized outputs " + actual + "instead of " + expected;
+        return false;
+    }
+    return true;
+}
+
+// a -> AND(a, unconnected) -> x and a -> OR(a, unconnected) -> y : x is 0, y is a wire
+static void testOptimizerConstants() {
+    GatePool pool;
+    Simulation::suspend(); // only compiled, never simulated
+    Gate* a = pool.create<Switch>();
+    Gate* andGate = pool.create<ANDGate>();
+    Gate* orGate = pool.create<ORGate>();
+    Gate* x = pool.create<Light>();
+    Gate* y = pool.create<Light>();
+    wire(a, 0, andGate, 0);
+    wire(a, 0, orGate, 0);
+    wire(andGate, 0, x, 0);
+    wire(orGate, 0, y, 0);
+    std::vector<Gate*> gates = { a, andGate, orGate, x, y };
+    Simulation::resume();
+
+    Netlist netlist = compileNetlist(gates);
+    OptimizedNetlist optimized = optimizeNetlist(netlist);
+
+    std::string reason;
+    bool passed = sameOutputs(netlist, optimized, reason);
+    if (passed && (optimized.foldedGates != 2 || optimized.netlist.gateCount() != 3)) {
+        reason = std::to_string(optimized.foldedGates) + " gates folded, " + std::to_string(optimized.netlist.gateCount()) + " left";
+        passed = false;
+    }
+
+    report("optimizer folds constant inputs", passed, reason);
+}
+
+// AND(a, b) twice, and NOT(NOT(a)) : one AND and no NOT are left
+static void testOptimizerCommonGates() {
+    GatePool pool;
+    Simulation::suspend(); // only compiled, never simulated
+    Gate* a = pool.create<Switch>();
+    Gate* b = pool.create<Switch>();
+    Gate* first = pool.create<ANDGate>();
+    Gate* second = pool.create<ANDGate>();
+    Gate* notA = pool.create<NOTGate>();
+    Gate* notNotA = pool.create<NOTGate>();
+    Gate* x = pool.create<Light>();
+    Gate* y = pool.create<Light>();
+    Gate* z = pool.create<Light>();
+    wire(a, 0, first, 0);
+    wire(b, 0, first, 1);
+    wire(a, 0, second, 0);
+    wire(b, 0, second, 1);
+    wire(a, 0, notA, 0);
+    wire(notA, 0, notNotA, 0);
+    wire(first, 0, x, 0);
+    wire(second, 0, y, 0);
+    wire(notNotA, 0, z, 0);
+    std::vector<Gate*> gates = { a, b, first, second, notA, notNotA, x, y, z };
+    Simulation::resume();
+
+    Netlist netlist = compileNetlist(gates);
+    OptimizedNetlist optimized = optimizeNetlist(netlist);
+
+    std::string reason;
+    bool passed = sameOutputs(netlist, optimized, reason);
+    if (passed && (optimized.mergedGates != 1 || optimized.inversions != 1 || optimized.netlist.gateCount() != 6)) {
+        reason = std::to_string(optimized.mergedGates) + " merged, " + std::to_string(optimized.inversions) + " inversions, " +
+                 std::to_string(optimized.netlist.gateCount()) + " gates left";
+        passed = false;
+    }
+
+    report("optimizer merges common gates and double inversions", passed, reason);
+}
+
+// s -> OR -> NOT -> NOT -> back into the OR, OR -> light : a latch holding a 1. The double inversion is
+// part of the loop, so nothing may be rewritten.
+static void testOptimizerKeepsLoops() {
+    GatePool pool;
+    Simulation::suspend(); // only compiled, never simulated
+    Gate* s = pool.create<Switch>();
+    Gate* orGate = pool.create<ORGate>();
+    Gate* first = pool.create<NOTGate>();
+    Gate* second = pool.create<NOTGate>();
+    Gate* out = pool.create<Light>();
+    wire(s, 0, orGate, 0);
+    wire(orGate, 0, first, 0);
+    wire(first, 0, second, 0);
+    wire(second, 0, orGate, 1);
+    wire(orGate, 0, out, 0);
+    std::vector<Gate*> gates = { s, orGate, first, second, out };
+    Simulation::resume();
+
+    Netlist netlist = compileNetlist(gates);
+    OptimizedNetlist optimized = optimizeNetlist(netlist);
+
+    std::string reason;
+    bool passed = sameOutputs(netlist, optimized, reason);
+    if (passed && (optimized.inversions != 0 || optimized.netlist.gateCount() != netlist.gateCount())) {
+        reason = "the loop was rewritten, " + std::to_string(optimized.netlist.gateCount()) + " gates left";
+        passed = false;
+    }
+
+    report("optimizer leaves feedback loops alone", passed, reason);
+}
+
+// in -> NOT -> NOT -> light with 3 units per NOT : the light follows the switch 6 units later
+static void testEventDelays() {
+    GatePool pool;
+    Netlist netlist = makeChain(pool);
+
+    GateDelays delays;
+    delays[GateType::NOT] = 3;
+    EventSimulation sim(netlist, delays);
+    sim.settle(MAX_SETTLE_TICKS);
+
+    sim.setInput(0, true);
+    SimTime start = sim.now();
+    bool early = sim.runUntil(start + 5) && sim.getOutput(0);
+    bool onTime = sim.runUntil(start + 6) && sim.getOutput(0);
+    bool passed = !early && onTime && sim.idle();
+
+    report("event simulation applies gate delays", passed, early ? "the light changed before 6 units" : "the light did not change at 6 units");
+}
+
+// A NOT gate reading its own output with no delay never settles : the step must stop at the delta cycle cap
+static void testEventDeltaCap() {
+    GatePool pool;
+    Simulation::suspend(); // only compiled, never simulated
+    Gate* inverter = pool.create<NOTGate>();
+    Gate* out = pool.create<Light>();
+    wire(inverter, 0, inverter, 0);
+    wire(inverter, 0, out, 0);
+    std::vector<Gate*> gates = { inverter, out };
+    Simulation::resume();
+    Netlist netlist = compileNetlist(gates);
+
+    GateDelays delays;
+    delays[GateType::NOT] = 0;
+    EventSimulation sim(netlist, delays);
+
+    bool settled = sim.settle(MAX_SETTLE_TICKS);
+    bool passed = !settled && sim.now() == 0;
+
+    report("event simulation stops a zero delay loop", passed, settled ? "the loop settled" : "the clock moved to " + std::to_string(sim.now()));
+}
+
+// Input i of pattern p, in exhaustive order : input 0 is the most significant bit
+static bool patternInput(int pattern, int input, int inputCount) {
+    return ((pattern >> (inputCount - 1 - input)) & 1) != 0;
+}
+
+// Sums every pattern of a 4 bit ripple adder in one evaluate : s = a + b + cin for all 512 of them
+template<class Sim>
+static bool checkAdder(Sim& sim, std::string& reason) {
+    const int bits = 4;
+    const int inputs = 2 * bits + 1;
+
+    for (int i = 0; i < inputs; i++) {
+        for (int word = 0; word < Sim::Patterns / 64; word++) {
+            sim.setInput(i, word, exhaustiveInputBits(i, inputs, (uint64_t)word * 64));
+        }
+    }
+    sim.evaluate();
+
+    for (int pattern = 0; pattern < (1 << inputs); pattern++) {
+        int a = 0, b = 0;
+        for (int bit = 0; bit < bits; bit++) {
+            a |= patternInput(pattern, 2 * bit, inputs) << bit;
+            b |= patternInput(pattern, 2 * bit + 1, inputs) << bit;
+        }
+        int expected = a + b + patternInput(pattern, inputs - 1, inputs);
+
+        int sum = 0;
+        for (int bit = 0; bit <= bits; bit++) {
+            sum |= (int)((sim.getOutput(bit, pattern / 64) >> (pattern % 64)) & 1) << bit;
+        }
+        if (sum != expected) {
+            reason = std::to_string(a) + " + " + std::to_string(b) + " gives " + std::to_string(sum);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void loadGenerated(const GeneratedCircuit& circuit, GatePool& pool, std::vector<Gate*>& gates) {
+    std::stringstream text;
+    circuit.write(text);
+    loadFromFile(gates, text, nullptr, &pool);
+}
+
+static void testPatternAdder() {
+    GeneratedCircuit circuit;
+    generateRippleAdder(circuit, 4);
+    GatePool pool;
+    std::vector<Gate*> gates;
+    Simulation::suspend(); // only compiled, never simulated
+    loadGenerated(circuit, pool, gates);
+    Simulation::resume();
+
+    PatternSimulation512 sim(compileNetlist(gates));
+    std::string reason = "the adder was taken for a sequential circuit";
+    bool passed = sim.isValid() && checkAdder(sim, reason);
+
+    report("pattern simulation adds every pattern at once", passed, reason);
+}
+
+static void testNativeAdder() {
+    GeneratedCircuit circuit;
+    generateRippleAdder(circuit, 4);
+    GatePool pool;
+    std::vector<Gate*> gates;
+    Simulation::suspend(); // only compiled, never simulated
+    loadGenerated(circuit, pool, gates);
+    Simulation::resume();
+
+    NativeSimulation sim(compileNetlist(gates));
+    if (!sim.isValid()) {
+        std::cout << "skip native simulation adds every pattern at once : " << sim.error << std::endl;
+        return;
+    }
+
+    std::string reason;
+    bool passed = checkAdder(sim, reason);
+
+    report("native simulation adds every pattern at once", passed, reason);
+}
+
+// in -> a, b, c ; removing a moves c into its slot
+static void testFanoutSwapRemove() {
+    FanoutTable table;
+    Pin a, b, c;
+    int list = table.addList();
+    table.add(list, &a);
+    table.add(list, &b);
+    table.add(list, &c);
+
+    table.remove(list, &a);
+
+    const Pin* const* entries = table.begin(list);
+    bool passed = table.size(list) == 2 && entries[0] == &c && entries[1] == &b &&
+                  c.fanoutSlot == 0 && b.fanoutSlot == 1 && a.fanoutSlot == -1;
+
+    report("fanout removal swaps the last entry in", passed, "wrong entries or slots after removing the first pin");
+}
+
+// Lists grown, shrunk and released at random, enough for the garbage to be compacted away many times,
+// must always hold exactly their pins, each at the slot it records
+static void testFanoutCompaction() {
+    const int listCount = 64;
+    const int pinCount = 4096;
+
+    FanoutTable table;
+    std::vector<Pin> pins(pinCount);
+    std::vector<int> lists(listCount);
+    std::vector<std::vector<Pin*>> expected(listCount);
+    for (auto& list : lists) {
+        list = table.addList();
+    }
+
+    uint32_t random = 12345;
+    auto next = [&random](uint32_t range) {
+        random = random * 1664525u + 1013904223u;
+        return (random >> 8) % range;
+    };
+
+    std::vector<int> listOf(pinCount, -1);
+    std::string reason;
+    bool passed = true;
+
+    for (int step = 0; step < 200000 && passed; step++) {
+        int p = (int)next(pinCount);
+        Pin* pin = &pins[p];
+
+        if (listOf[p] == -1) {
+            int l = (int)next(listCount);
+            table.add(lists[l], pin);
+            expected[l].push_back(pin);
+            listOf[p] = l;
+        }
+        else {
+            int l = listOf[p];
+            table.remove(lists[l], pin);
+            expected[l].erase(std::find(expected[l].begin(), expected[l].end(), pin));
+            listOf[p] = -1;
+        }
+
+        // now and then a list is dropped and made again, leaving garbage behind
+        if (next(1000) == 0) {
+            int l = (int)next(listCount);
+            table.clear(lists[l]);
+            table.releaseList(lists[l]);
+            lists[l] = table.addList();
+            for (auto gone : expected[l]) {
+                listOf[gone - pins.data()] = -1;
+            }
+            expected[l].clear();
+        }
+
+        if (step % 1000 != 0) { continue; }
+
+        for (int l = 0; l < listCount && passed; l++) {
+            std::vector<Pin*> actual(table.begin(lists[l]), table.end(lists[l]));
+            for (size_t i = 0; i < actual.size(); i++) {
+                if (actual[i]->fanoutSlot != (int)i) {
+                    reason = "a pin records the wrong slot at step " + std::to_string(step);
+                    passed = false;
+                }
+            }
+            std::sort(actual.begin(), actual.end());
+            std::vector<Pin*> sorted = expected[l];
+            std::sort(sorted.begin(), sorted.end());
+            if (passed && actual != sorted) {
+                reason = "list " + std::to_string(l) + " lost or gained pins at step " + std::to_string(step);
+                passed = false;
+            }
+        }
+    }
+
+    report("fanout table keeps its lists through growth and compaction", passed, reason);
+}
+
+static void writeTextFile(const std::string& fileName, const std::string& content) {
+    std::ofstream ofs(fileName, std::ofstream::out | std::ofstream::binary);
+    ofs << content;
+}
+
+// The library parses a file again only when its content changed, and a chip compiled into the cache
+// directory is not parsed by the next library
+static void testLibraryInvalidation() {
+    std::string inverter = "3\n0 4 0 0\n1 2 0 0\n2 5 0 0\n2\n1 0 0 0\n2 0 1 0\n";
+    std::string buffer = "4\n0 4 0 0\n1 2 0 0\n2 2 0 0\n3 5 0 0\n3\n1 0 0 0\n2 0 1 0\n3 0 2 0\n";
+
+    std::string reason;
+    bool passed = true;
+
+    {
+        ChipLibrary library;
+        library.setCacheDirectory(TEST_CACHE_DIRECTORY);
+
+        writeTextFile(TEST_TEXT_FILE, inverter);
+        ChipDefinition* first = library.get(TEST_TEXT_FILE, "CHIP", false);
+        ChipDefinition* again = library.get(TEST_TEXT_FILE, "CHIP", false);
+        writeTextFile(TEST_TEXT_FILE, inverter);
+        ChipDefinition* touched = library.get(TEST_TEXT_FILE, "CHIP", false);
+        if (first == nullptr || again != first || touched != first || library.parses != 1 || library.hits != 2) {
+            reason = "an unchanged file was parsed again";
+            passed = false;
+        }
+
+        writeTextFile(TEST_TEXT_FILE, buffer);
+        ChipDefinition* changed = library.get(TEST_TEXT_FILE, "CHIP", false);
+        if (passed && (changed == nullptr || changed == first || library.parses != 2 || truthTable(changed->netlist) != "0 1 ")) {
+            reason = "a changed file was not parsed again";
+            passed = false;
+        }
+    }
+
+    if (passed) {
+        ChipLibrary library;
+        library.setCacheDirectory(TEST_CACHE_DIRECTORY);
+
+        ChipDefinition* cached = library.get(TEST_TEXT_FILE, "CHIP", false);
+        if (cached == nullptr || library.cached != 1 || library.parses != 0 || truthTable(cached->netlist) != "0 1 ") {
+            reason = "the cache entry of the file was not used";
+            passed = false;
+        }
+    }
+
+    for (auto content : { inverter, buffer }) {
+        uint64_t key = chipCacheKey(hashBytes(FNV_OFFSET, content.data(), content.size()), false);
+        std::remove(chipCachePath(TEST_CACHE_DIRECTORY, key).c_str());
+    }
+    std::remove(TEST_CACHE_DIRECTORY);
+    std::remove(TEST_TEXT_FILE);
+
+    report("chip library only parses changed files", passed, reason);
+}
+
+// Outputs of the gate objects for every input pattern, in exhaustive order : what the engines must give
+static std::vector<std::string> objectOutputs(std::vector<Gate*>& gates) {
+    std::vector<Switch*> switches;
+    std::vector<Light*> lights;
+    for (auto gate : gates) {
+        if (gate->getGateType() == GateType::SWITCH) {
+            switches.push_back((Switch*)gate);
+        }
+        else if (gate->getGateType() == GateType::LIGHT) {
+            lights.push_back((Light*)gate);
+        }
+    }
+
+    int inputs = (int)switches.size();
+    std::vector<std::string> outputs;
+    Simulation::settle(Simulation::settleEventCap);
+
+    for (int pattern = 0; pattern < (1 << inputs); pattern++) {
+        for (int i = 0; i < inputs; i++) {
+            switches[i]->setState(patternInput(pattern, i, inputs));
+        }
+        Simulation::settle(Simulation::settleEventCap);
+
+        std::string bits;
+        for (auto light : lights) {
+            bits += light->getState() ? '1' : '0';
+        }
+        outputs.push_back(bits);
+    }
+
+    return outputs;
+}
+
+template<class Sim>
+static void setPattern(Sim& sim, int pattern, int inputs) {
+    for (int i = 0; i < inputs; i++) {
+        sim.setInput(i, patternInput(pattern, i, inputs));
+    }
+}
+
+template<class Sim>
+static std::string readOutputs(Sim& sim, int outputs) {
+    std::string bits;
+    for (int o = 0; o < outputs; o++) {
+        bits += sim.getOutput(o) ? '1' : '0';
+    }
+    return bits;
+}
+
+// getOutputs(pattern) runs one pattern on the engine and gives its outputs
+template<class GetOutputs>
+static void checkAgreement(const std::string& engine, const std::vector<std::string>& expected, GetOutputs getOutputs) {
+    std::string reason;
+    bool passed = true;
+
+    for (int pattern = 0; pattern < (int)expected.size(); pattern++) {
+        std::string actual = getOutputs(pattern);
+        if (actual != expected[pattern]) {
+            reason = "pattern " + std::to_string(pattern) + " gives " + actual + " instead of " + expected[pattern];
+            passed = false;
+            break;
+        }
+    }
+
+    report(engine + " agrees with the gate objects", passed, reason);
+}
+
+// Bit-parallel engines, Patterns at a time : the outputs of every pattern, in exhaustive order
+template<class Sim>
+static std::vector<std::string> parallelOutputs(Sim& sim, const Netlist& netlist) {
+    int inputs = (int)netlist.primaryInputs.size();
+    int outputCount = (int)netlist.primaryOutputs.size();
+    std::vector<std::string> outputs;
+
+    for (int first = 0; first < (1 << inputs); first += Sim::Patterns) {
+        for (int i = 0; i < inputs; i++) {
+            for (int word = 0; word < Sim::Patterns / 64; word++) {
+                sim.setInput(i, word, exhaustiveInputBits(i, inputs, (uint64_t)first + word * 64));
+            }
+        }
+        sim.evaluate();
+
+        for (int p = 0; p < Sim::Patterns && first + p < (1 << inputs); p++) {
+            std::string bits;
+            for (int o = 0; o < outputCount; o++) {
+                bits += ((sim.getOutput(o, p / 64) >> (p % 64)) & 1) ? '1' : '0';
+            }
+            outputs.push_back(bits);
+        }
+    }
+
+    return outputs;
+}
+
+// Every engine against the gate objects, on a random circuit from lgs-gen's generator
+static void testEnginesAgree() {
+    GeneratedCircuit circuit;
+    generateRandomDag(circuit, AGREEMENT_INPUTS, AGREEMENT_GATES, 24, 4, AGREEMENT_SEED);
+    GatePool pool;
+    std::vector<Gate*> gates;
+    loadGenerated(circuit, pool, gates);
+
+    std::vector<std::string> expected = objectOutputs(gates);
+    Netlist netlist = compileNetlist(gates);
+    int outputCount = (int)netlist.primaryOutputs.size();
+
+    {
+        NetlistSimulation sim(netlist);
+        checkAgreement("netlist simulation", expected, [&](int pattern) {
+            setPattern(sim, pattern, AGREEMENT_INPUTS);
+            sim.settle(MAX_SETTLE_TICKS);
+            return readOutputs(sim, outputCount);
+        });
+    }
+    {
+        OptimizedNetlist optimized = optimizeNetlist(netlist);
+        NetlistSimulation sim(optimized.netlist);
+        checkAgreement("optimized netlist simulation", expected, [&](int pattern) {
+            setPattern(sim, pattern, AGREEMENT_INPUTS);
+            sim.settle(MAX_SETTLE_TICKS);
+            return readOutputs(sim, outputCount);
+        });
+    }
+    {
+        EventSimulation sim(netlist);
+        sim.settle(MAX_SETTLE_TICKS);
+        checkAgreement("event simulation", expected, [&](int pattern) {
+            setPattern(sim, pattern, AGREEMENT_INPUTS);
+            sim.settle(MAX_SETTLE_TICKS);
+            return readOutputs(sim, outputCount);
+        });
+    }
+    {
+        LevelizedSimulation sim(netlist);
+        checkAgreement("levelized simulation", expected, [&](int pattern) {
+            setPattern(sim, pattern, AGREEMENT_INPUTS);
+            sim.evaluate();
+            return readOutputs(sim, outputCount);
+        });
+    }
+    {
+        PatternSimulation256 sim(netlist);
+        std::vector<std::string> outputs = parallelOutputs(sim, netlist);
+        checkAgreement("pattern simulation", expected, [&](int pattern) { return outputs[pattern]; });
+    }
+    {
+        NativeSimulation sim(netlist);
+        if (sim.isValid()) {
+            std::vector<std::string> outputs = parallelOutputs(sim, netlist);
+            checkAgreement("native simulation", expected, [&](int pattern) { return outputs[pattern]; });
+        }
+        else {
+            std::cout << "skip native simulation agrees with the gate objects : " << sim.error << std::endl;
+        }
+    }
+
+    pool.clear();
+}
+
+int main() {
+    testDestroyConnectedGate();
+    testChipPinDependencies();
+    testSettleInOrder();
+    testWireLoopThroughChip();
+    testLibraryRejectsBadIndices();
+    testCacheChecksSource();
+    testLibraryInvalidation();
+    testFanoutSwapRemove();
+    testFanoutCompaction();
+    testOptimizerConstants();
+    testOptimizerCommonGates();
+    testOptimizerKeepsLoops();
+    testEventDelays();
+    testEventDeltaCap();
+    testPatternAdder();
+    testNativeAdder();
+    testEnginesAgree();
+    testTopoSortSharedNested();
+    testTextRoundTripSharedNested();
+    testBinaryRoundTripSharedNested();
+
+    std::cout << (failures == 0 ? "all tests passed" : std::to_string(failures) + " failed") << std::endl;
+    return failures == 0 ? 0 : 1;
+}